@@ -0,0 +1,149 @@
+-- =========================================================
+-- ASSET MANAGER
+-- =========================================================
+-- Assets are decoded on love.thread workers (assetworker.lua) and
+-- finished on the main thread, where GPU uploads and audio sources have
+-- to be created. Finishing is spread over frames: update() stops once
+-- its time budget is spent and picks up the rest on the next frame.
+-- Handles are reference counted; loading the same asset twice shares
+-- one handle, and the asset is released when the last reference goes.
+--
+--   Assets.start()
+--   local h = Assets.load("image", "art/hero.png")   -- refs + 1
+--   Assets.update(budgetMs)                          -- once per frame
+--   if h.state == "ready" then draw(h.value) end
+--   Assets.release(h)                                -- refs - 1
+--
+-- Kinds: "image" (Image), "sound" (static Source), "data" (FileData)
+-- and "tileart" (ImageData painted by tileart.lua).
+
+require("love.thread")
+require("love.timer")
+
+local Assets = {}
+
+Assets.MAX_WORKERS = 2
+
+local getTime = love.timer.getTime
+
+local state = {
+    workers = {},
+    requests = nil,
+    results = nil,
+    handles = {}, -- [key] = handle
+    total = 0, -- requests since the manager was last idle
+    done = 0
+}
+
+-- Main-thread step turning decoded data into the asset itself
+local finishers = {
+    image = function(data)
+        local image = love.graphics.newImage(data)
+        data:release()
+        return image
+    end,
+    sound = function(data)
+        return love.audio and love.audio.newSource(data) or data
+    end
+}
+
+function Assets.start()
+    state.requests = love.thread.newChannel()
+    state.results = love.thread.newChannel()
+    local count = math.max(1, math.min(Assets.MAX_WORKERS, love.system.getProcessorCount() - 1))
+    for i = 1, count do
+        state.workers[i] = love.thread.newThread("assetworker.lua")
+        state.workers[i]:start(state.requests, state.results)
+    end
+end
+
+function Assets.stop()
+    if not state.requests then return end
+    state.requests:clear()
+    for _ = 1, #state.workers do
+        state.requests:push("quit")
+    end
+    for _, thread in ipairs(state.workers) do
+        thread:wait()
+    end
+    state.workers = {}
+    state.requests, state.results = nil, nil
+end
+
+-- `source` is a path, or for "tileart" a flat spec table. `key`
+-- defaults to kind:source, which only works for string sources.
+function Assets.load(kind, source, key)
+    key = key or kind .. ":" .. source
+    local handle = state.handles[key]
+    if handle then
+        handle.refs = handle.refs + 1
+        return handle
+    end
+
+    if state.done == state.total then
+        state.done, state.total = 0, 0
+    end
+    handle = { key = key, kind = kind, state = "loading", value = nil, err = nil, refs = 1 }
+    state.handles[key] = handle
+    state.total = state.total + 1
+    state.requests:push({ key = key, kind = kind, source = source })
+    return handle
+end
+
+function Assets.release(handle)
+    handle.refs = handle.refs - 1
+    if handle.refs > 0 then return end
+    if handle.value and handle.value.release then
+        handle.value:release()
+    end
+    handle.value = nil
+    handle.state = "released"
+    state.handles[handle.key] = nil
+end
+
+local function receive(msg)
+    state.done = state.done + 1
+    local handle = state.handles[msg.key]
+    if not handle then
+        -- Released while it was still loading
+        if msg.value then msg.value:release() end
+        return
+    end
+    if msg.err then
+        handle.state, handle.err = "failed", msg.err
+        print("asset " .. msg.key .. ": " .. msg.err)
+        return
+    end
+    local finish = finishers[handle.kind]
+    handle.value = finish and finish(msg.value) or msg.value
+    handle.state = "ready"
+end
+
+-- Finishes decoded assets until `budgetMs` has been spent
+function Assets.update(budgetMs)
+    if not state.results then return end
+    local stop = getTime() + budgetMs / 1000
+    repeat
+        local msg = state.results:pop()
+        if not msg then break end
+        receive(msg)
+    until getTime() >= stop
+end
+
+-- Blocks until every requested asset has arrived
+function Assets.finish()
+    while state.done < state.total do
+        receive(state.results:demand())
+    end
+end
+
+function Assets.isLoading()
+    return state.done < state.total
+end
+
+-- Assets finished and requested since the manager was last idle
+function Assets.progress()
+    return state.done, state.total
+end
+
+return Assets
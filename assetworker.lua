@@ -0,0 +1,33 @@
+-- =========================================================
+-- ASSET WORKER (love.thread)
+-- =========================================================
+-- Decodes assets for the main thread. Each request is { key, kind,
+-- source }; each reply is { key, value } or { key, err }. Decoded data
+-- (ImageData, SoundData, FileData) is shared with the main thread, not
+-- copied. Pushing "quit" stops the worker.
+
+require("love.filesystem")
+require("love.image")
+require("love.sound")
+local TileArt = require("tileart")
+
+local requests, results = ...
+
+local decoders = {
+    image = function(path) return love.image.newImageData(path) end,
+    sound = function(path) return love.sound.newSoundData(path) end,
+    data = function(path) return love.filesystem.newFileData(path) end,
+    tileart = TileArt.paint
+}
+
+while true do
+    local msg = requests:demand()
+    if msg == "quit" then break end
+
+    local ok, value = pcall(decoders[msg.kind], msg.source)
+    if ok then
+        results:push({ key = msg.key, value = value })
+    else
+        results:push({ key = msg.key, err = tostring(value) })
+    end
+end
@@ -0,0 +1,122 @@
+-- =========================================================
+-- BENCHMARK HARNESS
+-- =========================================================
+-- Command-line options and scripted input for `love . --bench`.
+--
+-- An input script is plain text, one event per line:
+--
+--   <tick> press <key>
+--   <tick> release <key>
+--   end <tick>            -- script length; playback loops after it
+--
+-- Ticks count fixed simulation steps from 1. Blank lines and lines
+-- starting with '#' are ignored.
+
+local Bench = {}
+
+Bench.DEFAULTS = {
+    script = "bench/walkthrough.txt",
+    steps = 20000,
+    seed = 1,
+    render = false, -- also time rendering (needs a window)
+    frames = 600,
+    replay = nil, -- recorded session to play instead of the script
+    trace = nil -- per-tick player state CSV, for diffing trajectories
+}
+
+function Bench.hasFlag(args, flag)
+    for _, a in ipairs(args or {}) do
+        if a == flag then return true end
+    end
+    return false
+end
+
+function Bench.isRequested(args)
+    return Bench.hasFlag(args, "--bench")
+end
+
+function Bench.isRenderRequested(args)
+    return Bench.hasFlag(args, "--render")
+end
+
+-- --bench [--script path] [--steps n] [--seed n] [--render] [--frames n]
+--         [--replay path] [--trace path] [--no-ffi]
+-- (--no-ffi is read by main.lua, before the options are parsed)
+function Bench.parseArgs(args)
+    local opts = {}
+    for k, v in pairs(Bench.DEFAULTS) do
+        opts[k] = v
+    end
+    local i = 1
+    while i <= #args do
+        local a = args[i]
+        if a == "--script" then
+            opts.script = args[i + 1]; i = i + 1
+        elseif a == "--steps" then
+            opts.steps = tonumber(args[i + 1]); i = i + 1
+        elseif a == "--seed" then
+            opts.seed = tonumber(args[i + 1]); i = i + 1
+        elseif a == "--frames" then
+            opts.frames = tonumber(args[i + 1]); i = i + 1
+        elseif a == "--replay" then
+            opts.replay = args[i + 1]; i = i + 1
+        elseif a == "--trace" then
+            opts.trace = args[i + 1]; i = i + 1
+        elseif a == "--render" then
+            opts.render = true
+        end
+        i = i + 1
+    end
+    return opts
+end
+
+function Bench.loadScript(path)
+    local contents, err = love.filesystem.read(path)
+    if not contents then
+        error("cannot read input script " .. path .. ": " .. tostring(err))
+    end
+
+    local script = { events = {}, length = 1 }
+    local n = 0
+    for line in contents:gmatch("[^\r\n]+") do
+        if not line:match("^%s*#") and line:match("%S") then
+            local tick, action, key = line:match("^%s*(%d+)%s+(%a+)%s+(%S+)")
+            local endTick = line:match("^%s*end%s+(%d+)")
+            if endTick then
+                script.length = tonumber(endTick)
+            elseif tick and (action == "press" or action == "release") then
+                n = n + 1
+                script.events[n] = { tick = tonumber(tick), down = action == "press", key = key }
+                script.length = math.max(script.length, tonumber(tick))
+            else
+                error(path .. ": cannot parse '" .. line .. "'")
+            end
+        end
+    end
+    table.sort(script.events, function(a, b) return a.tick < b.tick end)
+    return script
+end
+
+-- Feeds script events for simulation step `tick` to onKey(key, down),
+-- looping the script once `tick` runs past its length
+function Bench.newReplay(script)
+    return { script = script, cursor = 1, loop = 0 }
+end
+
+function Bench.replayStep(replay, tick, onKey)
+    local script = replay.script
+    local loop = math.floor((tick - 1) / script.length)
+    if loop ~= replay.loop then
+        replay.loop = loop
+        replay.cursor = 1
+    end
+    local localTick = tick - loop * script.length
+    local events = script.events
+    while events[replay.cursor] and events[replay.cursor].tick <= localTick do
+        local ev = events[replay.cursor]
+        onKey(ev.key, ev.down)
+        replay.cursor = replay.cursor + 1
+    end
+end
+
+return Bench
@@ -1,3 +1,14 @@
 #!/bin/bash
 set -e
-love .
+
+case "$1" in
+    bench)
+        # ./build.sh bench [--steps n] [--script path] [--seed n] [--render]
+        #                  [--replay path] [--trace path] [--no-ffi]
+        shift
+        love . --bench "$@"
+        ;;
+    *)
+        love .
+        ;;
+esac
@@ -0,0 +1,102 @@
+-- =========================================================
+-- CAMERA
+-- =========================================================
+-- Follows a target through a dead-zone, leads it in the direction of
+-- travel and eases towards the result with exponential smoothing, so
+-- the motion is the same at any frame rate. The view size is cached and
+-- only changes through resize (wired to love.resize).
+--
+-- After every move the camera also keeps the range of tiles it can see
+-- (tileX1..tileX2, tileY1..tileY2, 1-based, not clamped to the world),
+-- which culling and streaming read instead of working it out again.
+
+local Camera = {}
+Camera.__index = Camera
+
+local LOOK_MIN_SPEED = 40 -- px/s before look-ahead picks a direction
+
+function Camera.new(tileSize, viewW, viewH)
+    local cam = setmetatable({
+        x = 0, y = 0,
+        viewW = viewW, viewH = viewH,
+        boundsW = math.huge, boundsH = math.huge,
+        tileSize = tileSize,
+
+        deadZoneW = 64, deadZoneH = 96, -- px the target moves before the camera follows
+        lookAhead = 96, -- px led in the direction of travel
+        lookRate = 3, -- look-ahead easing, per second
+        smooth = 10, -- position easing, per second
+
+        focusX = 0, focusY = 0, -- followed point, kept inside the dead-zone
+        lookX = 0,
+
+        tileX1 = 1, tileY1 = 1, tileX2 = 1, tileY2 = 1
+    }, Camera)
+    cam:refreshTiles()
+    return cam
+end
+
+-- World size in pixels; the view is kept inside it
+function Camera:setBounds(w, h)
+    self.boundsW, self.boundsH = w, h
+end
+
+function Camera:resize(w, h)
+    self.viewW, self.viewH = w, h
+    self:setPosition(self.x, self.y)
+end
+
+function Camera:refreshTiles()
+    local ts = self.tileSize
+    self.tileX1 = math.floor(self.x / ts) + 1
+    self.tileY1 = math.floor(self.y / ts) + 1
+    self.tileX2 = math.floor((self.x + self.viewW) / ts) + 1
+    self.tileY2 = math.floor((self.y + self.viewH) / ts) + 1
+end
+
+local function clampView(pos, size, bound)
+    return math.max(0, math.min(pos, bound - size))
+end
+
+-- Moves the view directly, keeping it inside the bounds
+function Camera:setPosition(x, y)
+    self.x = clampView(x, self.viewW, self.boundsW)
+    self.y = clampView(y, self.viewH, self.boundsH)
+    self:refreshTiles()
+end
+
+-- Centres on (px, py) immediately, dropping any look-ahead
+function Camera:snap(px, py)
+    self.focusX, self.focusY = px, py
+    self.lookX = 0
+    self:setPosition(px - self.viewW / 2, py - self.viewH / 2)
+end
+
+-- Follows the point (px, py), which moves horizontally at vx
+function Camera:update(dt, px, py, vx)
+    local hw, hh = self.deadZoneW / 2, self.deadZoneH / 2
+    self.focusX = math.max(px - hw, math.min(self.focusX, px + hw))
+    self.focusY = math.max(py - hh, math.min(self.focusY, py + hh))
+
+    -- Standing still keeps the current lead instead of recentring
+    if vx > LOOK_MIN_SPEED or vx < -LOOK_MIN_SPEED then
+        local lead = vx > 0 and self.lookAhead or -self.lookAhead
+        self.lookX = self.lookX + (lead - self.lookX) * (1 - math.exp(-self.lookRate * dt))
+    end
+
+    local tx = clampView(self.focusX + self.lookX - self.viewW / 2, self.viewW, self.boundsW)
+    local ty = clampView(self.focusY - self.viewH / 2, self.viewH, self.boundsH)
+    local k = 1 - math.exp(-self.smooth * dt)
+    self:setPosition(self.x + (tx - self.x) * k, self.y + (ty - self.y) * k)
+end
+
+-- Applies the view transform to the current love.graphics state.
+-- `scale` is target pixels per world pixel (default 1); the offset is
+-- rounded to whole target pixels so tile edges stay on the pixel grid.
+function Camera:apply(scale)
+    scale = scale or 1
+    love.graphics.translate(-math.floor(self.x * scale + 0.5) / scale,
+        -math.floor(self.y * scale + 0.5) / scale)
+end
+
+return Camera
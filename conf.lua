@@ -0,0 +1,22 @@
+-- =========================================================
+-- LOVE CONFIGURATION
+-- =========================================================
+-- `love . --bench` runs the simulation benchmark headless: no window
+-- or graphics. Adding `--render` keeps a window (without vsync) for the
+-- render timings.
+
+local Bench = require("bench")
+
+function love.conf(t)
+    if Bench.isRequested(arg) then
+        t.modules.audio = false
+        t.modules.sound = false
+        if Bench.isRenderRequested(arg) then
+            t.window.vsync = 0
+        else
+            t.window = nil
+            t.modules.window = false
+            t.modules.graphics = false
+        end
+    end
+end
@@ -0,0 +1,26 @@
+-- =========================================================
+-- WORLD GENERATION WORKER (love.thread)
+-- =========================================================
+-- Generates chunks for the main thread. Requests are chunk indices
+-- pushed on the request channel; each reply is { index, data } where
+-- data is a ByteData of the chunk's raw tile bytes. ByteData is shared
+-- between threads rather than copied, so the main thread reads the
+-- bytes in place. Pushing "quit" stops the worker.
+
+require("love.data")
+local WorldGen = require("worldgen")
+
+local chunkSize, chunkCols, requests, results = ...
+
+local tiles = {}
+
+while true do
+    local msg = requests:demand()
+    if msg == "quit" then break end
+
+    local cx = (msg - 1) % chunkCols + 1
+    local cy = math.floor((msg - 1) / chunkCols) + 1
+    WorldGen.generateChunk(cx, cy, chunkSize, tiles)
+    local data = love.data.newByteData(string.char(unpack(tiles, 1, chunkSize * chunkSize)))
+    results:push({ index = msg, data = data })
+end
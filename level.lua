@@ -0,0 +1,209 @@
+-- =========================================================
+-- LEVEL FILE FORMAT
+-- =========================================================
+-- A level is a fixed header, a chunk offset table, then every chunk's
+-- tiles run-length encoded. Chunks are stored in row-major order and
+-- are padded to full size on the right and bottom edges, so any chunk
+-- can be read with a single seek without touching the rest of the file.
+--
+--   "GGLV"  magic
+--   u16     version
+--   u16     chunk size (tiles per side)
+--   u32     width (tiles)
+--   u32     height (tiles)
+--   u32     offsets[chunkCount + 1]  byte offset of each chunk's runs;
+--                                    the last entry is the end of file
+--   runs    (count u8 1..255, tile id u8) pairs, row-major per chunk
+--
+-- Only string/love.data/love.filesystem calls are used, so this module
+-- also loads inside love.thread workers.
+
+require("love.data")
+require("love.filesystem")
+
+local Level = {}
+
+Level.MAGIC = "GGLV"
+Level.VERSION = 2
+Level.HEADER_SIZE = 16
+
+local HEADER_FORMAT = "<I2I2I4I4"
+local MAX_RUN = 255
+
+local byte, char, rep = string.byte, string.char, string.rep
+
+function Level.chunkCount(header)
+    return header.chunkCols * header.chunkRows
+end
+
+local function makeHeader(version, chunkSize, width, height)
+    return {
+        version = version,
+        chunkSize = chunkSize,
+        width = width,
+        height = height,
+        chunkCols = math.ceil(width / chunkSize),
+        chunkRows = math.ceil(height / chunkSize),
+        offsets = nil -- filled by parseOffsets
+    }
+end
+
+-- Header of a level that has not been written yet (no offset table)
+function Level.newHeader(chunkSize, width, height)
+    return makeHeader(Level.VERSION, chunkSize, width, height)
+end
+
+local function indexSize(header)
+    return (Level.chunkCount(header) + 1) * 4
+end
+
+-- Parses the fixed header from the start of a level. Returns nil and
+-- a message if the data is not a level we can read.
+function Level.parseHeader(data)
+    if #data < Level.HEADER_SIZE or data:sub(1, 4) ~= Level.MAGIC then
+        return nil, "not a level file"
+    end
+    local version, chunkSize, width, height = love.data.unpack(HEADER_FORMAT, data, 5)
+    if version ~= Level.VERSION then
+        return nil, "unsupported level version " .. version
+    end
+    return makeHeader(version, chunkSize, width, height)
+end
+
+-- Reads the chunk offset table starting at `pos` in `data`
+local function parseOffsets(header, data, pos)
+    local offsets = {}
+    for i = 1, Level.chunkCount(header) + 1 do
+        offsets[i] = love.data.unpack("<I4", data, pos + (i - 1) * 4)
+    end
+    header.offsets = offsets
+end
+
+-- Header and offset table of a level on disk
+function Level.readHeader(path)
+    local file = love.filesystem.newFile(path, "r")
+    local data = file:read(Level.HEADER_SIZE)
+    local header, err = Level.parseHeader(data or "")
+    if header then
+        local index = file:read(indexSize(header))
+        if #index == indexSize(header) then
+            parseOffsets(header, index, 1)
+        else
+            header, err = nil, "truncated level file"
+        end
+    end
+    file:close()
+    return header, err
+end
+
+-- Expands one chunk's runs into CHUNK * CHUNK raw tile bytes
+function Level.decodeChunk(data)
+    local parts = {}
+    for i = 1, #data, 2 do
+        local count, id = byte(data, i, i + 1)
+        parts[#parts + 1] = rep(char(id), count)
+    end
+    return table.concat(parts)
+end
+
+-- Reads one chunk's raw tile bytes from an open love File
+function Level.readChunk(file, header, cx, cy)
+    local index = (cy - 1) * header.chunkCols + cx
+    local offset = header.offsets[index]
+    file:seek(offset)
+    return Level.decodeChunk((file:read(header.offsets[index + 1] - offset)))
+end
+
+-- Reads a whole level into the flat row-major array `tiles` in one
+-- pass, writing tile ids straight from the runs. Returns the header.
+function Level.load(path, tiles)
+    local data, err = love.filesystem.read(path)
+    if not data then
+        return nil, err
+    end
+    local header
+    header, err = Level.parseHeader(data)
+    if not header then
+        return nil, err
+    end
+    parseOffsets(header, data, Level.HEADER_SIZE + 1)
+
+    local size, width, height = header.chunkSize, header.width, header.height
+    local offsets = header.offsets
+    local index = 0
+    for cy = 1, header.chunkRows do
+        for cx = 1, header.chunkCols do
+            index = index + 1
+            local x0, y0 = (cx - 1) * size, (cy - 1) * size
+            local lx, ly = 0, 0
+            for i = offsets[index] + 1, offsets[index + 1], 2 do
+                local count, id = byte(data, i, i + 1)
+                for _ = 1, count do
+                    local tx, ty = x0 + lx + 1, y0 + ly + 1
+                    if tx <= width and ty <= height then
+                        tiles[(ty - 1) * width + tx] = id
+                    end
+                    lx = lx + 1
+                    if lx == size then
+                        lx, ly = 0, ly + 1
+                    end
+                end
+            end
+        end
+    end
+    return header
+end
+
+-- Serialises a level whose tiles are given by getTile(tx, ty)
+function Level.encode(width, height, chunkSize, getTile)
+    local header = makeHeader(Level.VERSION, chunkSize, width, height)
+    local chunks = {}
+    local offsets = {}
+    local offset = Level.HEADER_SIZE + indexSize(header)
+
+    for cy = 1, header.chunkRows do
+        for cx = 1, header.chunkCols do
+            local runs = {}
+            local runId, runCount = nil, 0
+            for ly = 1, chunkSize do
+                local ty = (cy - 1) * chunkSize + ly
+                for lx = 1, chunkSize do
+                    local tx = (cx - 1) * chunkSize + lx
+                    local id = 0
+                    if tx <= width and ty <= height then
+                        id = getTile(tx, ty)
+                    end
+                    if id == runId and runCount < MAX_RUN then
+                        runCount = runCount + 1
+                    else
+                        if runId then
+                            runs[#runs + 1] = char(runCount, runId)
+                        end
+                        runId, runCount = id, 1
+                    end
+                end
+            end
+            runs[#runs + 1] = char(runCount, runId)
+
+            offsets[#offsets + 1] = love.data.pack("string", "<I4", offset)
+            chunks[#chunks + 1] = table.concat(runs)
+            offset = offset + #chunks[#chunks]
+        end
+    end
+    offsets[#offsets + 1] = love.data.pack("string", "<I4", offset)
+
+    return Level.MAGIC
+        .. love.data.pack("string", HEADER_FORMAT, header.version, chunkSize, width, height)
+        .. table.concat(offsets)
+        .. table.concat(chunks)
+end
+
+function Level.write(path, width, height, chunkSize, getTile)
+    local dir = path:match("^(.*)/[^/]*$")
+    if dir then
+        love.filesystem.createDirectory(dir)
+    end
+    return love.filesystem.write(path, Level.encode(width, height, chunkSize, getTile))
+end
+
+return Level
@@ -2,58 +2,549 @@
 -- HOLLOW KNIGHT–STYLE PLATFORMER (BIG WORLD + CAMERA)
 -- =========================================================
 
+local bit = require("bit")
+local Assets = require("assets")
+local Bench = require("bench")
+local Camera = require("camera")
+local Level = require("level")
+local Memory = require("memory")
+local Pool = require("pool")
+local Profiler = require("profiler")
+local Quality = require("quality")
+local Replay = require("replay")
+local Rooms = require("rooms")
+local SpatialHash = require("spatialhash")
+local TileArt = require("tileart")
+local Tileset = require("tileset")
+local WorldGen = require("worldgen")
+
+-- Under LuaJIT the tile store, collision caches and entity columns are
+-- C arrays (see newArray); --no-ffi forces the plain Lua tables
+local hasFFI, ffi = pcall(require, "ffi")
+if not hasFFI or Bench.hasFlag(arg, "--no-ffi") then ffi = nil end
+
 local TILE = 32
+local TILE_EMPTY = 0
+local TILE_SOLID = 1
+local TILE_BREAKABLE = 2 -- solid until hit by a projectile
+local SOLID = { [TILE_SOLID] = true, [TILE_BREAKABLE] = true }
 local GRAVITY = 1800
 local MAX_FALL = 900
+local DRAW_MARGIN = 1 -- extra tiles drawn around the view
+local CHUNK = 16 -- tiles per render and streaming chunk side
+local STREAM_RADIUS = 1 -- chunks kept loaded beyond the view
+local LEVEL_PATH = "levels/world-r" .. WorldGen.REVISION .. ".lvl"
+local PARTICLE_CAPACITY = 512
+local LAYER_TILE = 512 -- background canvas tile size in pixels
+local LAYER_BASE_Y = 252 -- background pillar baseline, independent of the window
+local FIXED_DT = 1 / 120 -- simulation step
+local MAX_STEPS = 8 -- simulation steps per frame before dropping time
+local ASSET_BUDGET_MS = 2 -- main-thread asset finishing per frame
 
 -- ======================
 -- WORLD
 -- ======================
+-- The built-in layout is baked to a level file the first time the game
+-- runs, or when the baked file is from an older format or layout. Until
+-- then the header only gives the world's size, and chunks come from the
+-- generator (see WORLD GENERATION) instead of the file.
+local levelHeader = love.filesystem.getInfo(LEVEL_PATH) and Level.readHeader(LEVEL_PATH)
+local levelBaked = levelHeader ~= nil
+if not levelBaked then
+    levelHeader = Level.newHeader(CHUNK, WorldGen.WIDTH, WorldGen.HEIGHT)
+end
+assert(levelHeader.chunkSize == CHUNK, "level chunk size does not match CHUNK")
+
+-- Flat numeric array indexed 1..size: a zeroed C array of `ctype` on
+-- the FFI path, a table otherwise. Every slot starts as `fill`; nil
+-- leaves a table sparse.
+local function newArray(ctype, size, fill)
+    if ffi then
+        local a = ffi.new(ctype .. "[?]", size + 1)
+        if fill and fill ~= 0 then
+            for i = 1, size do a[i] = fill end
+        end
+        return a
+    end
+    local a = {}
+    if fill ~= nil then
+        for i = 1, size do a[i] = fill end
+    end
+    return a
+end
+
+-- Value of a tile slot whose chunk is not loaded: absent from the
+-- table store, 0 in a C array
+local NO_TILE = ffi and 0 or nil
+
+-- Tiles are streamed in per chunk; slots of chunks that are not
+-- resident hold NO_TILE
 local world = {
-    width = 120,
-    height = 40,
-    tiles = {}
+    width = levelHeader.width,
+    height = levelHeader.height,
+    chunkCols = levelHeader.chunkCols,
+    chunkRows = levelHeader.chunkRows,
+    tiles = newArray("uint8_t", levelHeader.width * levelHeader.height, NO_TILE), -- row-major, see tileIndex
+    resident = {}, -- [chunkIndex] = true while loaded
+    generated = {} -- [chunkIndex] = ByteData, until the level is baked
+}
+
+local function tileIndex(tx, ty)
+    return (ty - 1) * world.width + tx
+end
+
+local function inBounds(tx, ty)
+    return tx >= 1 and ty >= 1 and tx <= world.width and ty <= world.height
+end
+
+-- Out-of-bounds and not-yet-loaded reads return 0 (empty)
+local function getTile(tx, ty)
+    if tx < 1 or ty < 1 or tx > world.width or ty > world.height then
+        return 0
+    end
+    return world.tiles[(ty - 1) * world.width + tx] or 0
+end
+
+local function chunkIndex(cx, cy)
+    return (cy - 1) * world.chunkCols + cx
+end
+
+local function chunkCoords(index)
+    return (index - 1) % world.chunkCols + 1, math.floor((index - 1) / world.chunkCols) + 1
+end
+
+local function chunkOfTile(tx, ty)
+    return math.floor((tx - 1) / CHUNK) + 1, math.floor((ty - 1) / CHUNK) + 1
+end
+
+local function isResidentAt(px, py)
+    local cx = math.floor(px / (TILE * CHUNK)) + 1
+    local cy = math.floor(py / (TILE * CHUNK)) + 1
+    return world.resident[chunkIndex(cx, cy)] == true
+end
+
+-- Tile range of a chunk, clamped to the world
+local function chunkTileRange(index)
+    local cx, cy = chunkCoords(index)
+    local x1, y1 = (cx - 1) * CHUNK + 1, (cy - 1) * CHUNK + 1
+    return x1, y1, math.min(world.width, x1 + CHUNK - 1), math.min(world.height, y1 + CHUNK - 1)
+end
+
+-- ======================
+-- SOLIDITY CACHE
+-- ======================
+-- Collision never reads tile ids directly; it uses two caches built
+-- per chunk when the chunk is loaded:
+--   * solidBits: one bit per tile, 32 tiles per word, row-major
+--   * runsH / runsV: for each tile, how many empty tiles start at it
+--     going right and left (runsH = right + left * RUN_BASE), or down
+--     and up (runsV). Solid tiles store 0. Runs stop at the chunk edge,
+--     so a chunk can be rebuilt without looking at its neighbours.
+-- Scans can then skip a whole empty span, or reach the chunk edge, in one step.
+local band, bor, bnot, lshift, rshift = bit.band, bit.bor, bit.bnot, bit.lshift, bit.rshift
+
+local RUN_BASE = 32
+assert(CHUNK < RUN_BASE, "runs are packed in RUN_BASE-sized fields")
+
+-- Run slot of a tile whose chunk is not loaded; scans skip the chunk
+local NO_RUN = ffi and 0xFFFF or nil
+
+local ROW_WORDS = math.ceil(world.width / 32)
+world.solidBits = newArray("int32_t", ROW_WORDS * world.height, 0)
+world.rects = {} -- [chunkIndex] = merged solid rectangles, see rebuildChunkRects
+world.runsH = newArray("uint16_t", world.width * world.height, NO_RUN)
+world.runsV = newArray("uint16_t", world.width * world.height, NO_RUN)
+
+local function setSolidBit(tx, ty, solid)
+    local x = tx - 1
+    local i = (ty - 1) * ROW_WORDS + rshift(x, 5) + 1
+    local mask = lshift(1, band(x, 31))
+    local bits = world.solidBits
+    if solid then
+        bits[i] = bor(bits[i], mask)
+    else
+        bits[i] = band(bits[i], bnot(mask))
+    end
+end
+
+-- Recomputes horizontal runs for tiles x1..x2 of row ty (one chunk wide)
+local function rebuildRunsH(ty, x1, x2)
+    local tiles, runsH = world.tiles, world.runsH
+    local row = (ty - 1) * world.width
+    local run = 0
+    for tx = x2, x1, -1 do
+        run = SOLID[tiles[row + tx]] and 0 or run + 1
+        runsH[row + tx] = run
+    end
+    run = 0
+    for tx = x1, x2 do
+        local i = row + tx
+        run = SOLID[tiles[i]] and 0 or run + 1
+        runsH[i] = runsH[i] + run * RUN_BASE
+    end
+end
+
+-- Recomputes vertical runs for tiles y1..y2 of column tx (one chunk tall)
+local function rebuildRunsV(tx, y1, y2)
+    local tiles, runsV, w = world.tiles, world.runsV, world.width
+    local run = 0
+    for ty = y2, y1, -1 do
+        local i = (ty - 1) * w + tx
+        run = SOLID[tiles[i]] and 0 or run + 1
+        runsV[i] = run
+    end
+    run = 0
+    for ty = y1, y2 do
+        local i = (ty - 1) * w + tx
+        run = SOLID[tiles[i]] and 0 or run + 1
+        runsV[i] = runsV[i] + run * RUN_BASE
+    end
+end
+
+-- Greedy-merges the chunk's solid tiles into rectangles of one tile
+-- id: each unclaimed solid tile (row-major) grows right as far as it
+-- can, then down while the whole span has the same id.
+-- world.rects[index] holds them flat as x, y, w, h (in tiles, 1-based)
+-- and id, RECT_STRIDE values each, with the count in `n`. Gameplay
+-- reads the runs, so the rectangles are only built for the F2 overlay,
+-- on demand; loads and edits just mark them stale.
+local RECT_STRIDE = 5
+local rectClaimed = {}
+
+local function rebuildChunkRects(index)
+    local x1, y1, x2, y2 = chunkTileRange(index)
+    local tiles, w = world.tiles, world.width
+    local claimed = rectClaimed
+    for i = 1, CHUNK * CHUNK do
+        claimed[i] = false
+    end
+
+    local rects = world.rects[index] or {}
+    local n = 0
+    for ty = y1, y2 do
+        for tx = x1, x2 do
+            local cell = (ty - y1) * CHUNK + (tx - x1) + 1
+            local id = tiles[(ty - 1) * w + tx]
+            if not claimed[cell] and SOLID[id] then
+                local ex = tx
+                while ex < x2 and not claimed[cell + ex - tx + 1]
+                    and tiles[(ty - 1) * w + ex + 1] == id do
+                    ex = ex + 1
+                end
+
+                local ey = ty
+                local grow = true
+                while grow and ey < y2 do
+                    local row = ey * w
+                    local base = (ey + 1 - y1) * CHUNK - x1 + 1
+                    for x = tx, ex do
+                        if claimed[base + x] or tiles[row + x] ~= id then
+                            grow = false
+                            break
+                        end
+                    end
+                    if grow then ey = ey + 1 end
+                end
+
+                for y = ty, ey do
+                    local base = (y - y1) * CHUNK - x1 + 1
+                    for x = tx, ex do
+                        claimed[base + x] = true
+                    end
+                end
+                rects[n + 1], rects[n + 2], rects[n + 3], rects[n + 4] = tx, ty, ex - tx + 1, ey - ty + 1
+                rects[n + 5] = id
+                n = n + RECT_STRIDE
+            end
+        end
+    end
+    for i = n + 1, #rects do
+        rects[i] = nil
+    end
+    rects.n = n / RECT_STRIDE
+    rects.stale = false
+    world.rects[index] = rects
+end
+
+local function staleChunkRects(index)
+    local rects = world.rects[index]
+    if rects then rects.stale = true end
+end
+
+local function rebuildSolidChunk(index)
+    local x1, y1, x2, y2 = chunkTileRange(index)
+    local tiles, w = world.tiles, world.width
+    for ty = y1, y2 do
+        local row = (ty - 1) * w
+        for tx = x1, x2 do
+            setSolidBit(tx, ty, SOLID[tiles[row + tx]])
+        end
+        rebuildRunsH(ty, x1, x2)
+    end
+    for tx = x1, x2 do
+        rebuildRunsV(tx, y1, y2)
+    end
+    staleChunkRects(index)
+end
+
+local function clearSolidChunk(index)
+    local x1, y1, x2, y2 = chunkTileRange(index)
+    local runsH, runsV, w = world.runsH, world.runsV, world.width
+    for ty = y1, y2 do
+        local row = (ty - 1) * w
+        for tx = x1, x2 do
+            setSolidBit(tx, ty, false)
+            runsH[row + tx] = NO_RUN
+            runsV[row + tx] = NO_RUN
+        end
+    end
+    world.rects[index] = nil
+end
+
+-- Refreshes the caches after tile (tx, ty) changed: one bit, and the
+-- runs of its row and column inside its chunk
+local function updateSolidTile(tx, ty)
+    setSolidBit(tx, ty, SOLID[world.tiles[tileIndex(tx, ty)]])
+    local index = chunkIndex(chunkOfTile(tx, ty))
+    local x1, y1, x2, y2 = chunkTileRange(index)
+    rebuildRunsH(ty, x1, x2)
+    rebuildRunsV(tx, y1, y2)
+    staleChunkRects(index)
+end
+
+-- ======================
+-- AUTOTILE MASKS
+-- ======================
+-- Each non-empty tile keeps an 8-neighbour mask of which neighbours
+-- have the same id, in world.masks (parallel to world.tiles). Corner
+-- bits are only kept when both sides next to the corner connect, which
+-- leaves 47 distinct masks; the renderer maps (id, mask) straight to a
+-- tileset quad. Masks are refreshed for the tiles around a chunk as it
+-- is loaded or dropped, and around a tile when it is edited.
+local AUTO_N, AUTO_E, AUTO_S, AUTO_W = 1, 2, 4, 8
+local AUTO_NE, AUTO_SE, AUTO_SW, AUTO_NW = 16, 32, 64, 128
+
+-- Neighbour offsets, in bit order
+local AUTO_BITS = {
+    { 0, -1, AUTO_N }, { 1, 0, AUTO_E }, { 0, 1, AUTO_S }, { -1, 0, AUTO_W },
+    { 1, -1, AUTO_NE }, { 1, 1, AUTO_SE }, { -1, 1, AUTO_SW }, { -1, -1, AUTO_NW }
 }
 
-for y = 1, world.height do
-    world.tiles[y] = {}
-    for x = 1, world.width do
-        world.tiles[y][x] = 0
+local AUTOTILE_REDUCE = {} -- [raw mask] = mask with unused corners cleared
+for m = 0, 255 do
+    local r = band(m, AUTO_N + AUTO_E + AUTO_S + AUTO_W)
+    local function keep(corner, a, b)
+        if band(m, a + b) == a + b then
+            r = bor(r, band(m, corner))
+        end
+    end
+    keep(AUTO_NE, AUTO_N, AUTO_E)
+    keep(AUTO_SE, AUTO_S, AUTO_E)
+    keep(AUTO_SW, AUTO_S, AUTO_W)
+    keep(AUTO_NW, AUTO_N, AUTO_W)
+    AUTOTILE_REDUCE[m] = r
+end
+
+world.masks = {}
+
+-- Defined with the tile renderer
+local markChunkDirty
+
+-- Recomputes the masks of tiles x1..x2, y1..y2 (clamped to the world)
+-- and dirties the chunks they belong to
+local function refreshMasks(x1, y1, x2, y2)
+    x1, y1 = math.max(1, x1), math.max(1, y1)
+    x2, y2 = math.min(world.width, x2), math.min(world.height, y2)
+    local tiles, masks, w = world.tiles, world.masks, world.width
+    for ty = y1, y2 do
+        for tx = x1, x2 do
+            local i = (ty - 1) * w + tx
+            local id = tiles[i]
+            if id and id ~= TILE_EMPTY then
+                local m = 0
+                for b = 1, 8 do
+                    local n = AUTO_BITS[b]
+                    if getTile(tx + n[1], ty + n[2]) == id then
+                        m = m + n[3]
+                    end
+                end
+                masks[i] = AUTOTILE_REDUCE[m]
+            else
+                masks[i] = nil
+            end
+        end
+    end
+
+    local cx1, cy1 = chunkOfTile(x1, y1)
+    local cx2, cy2 = chunkOfTile(x2, y2)
+    for cy = cy1, cy2 do
+        for cx = cx1, cx2 do
+            markChunkDirty(chunkIndex(cx, cy))
+        end
+    end
+end
+
+-- A chunk's own tiles plus the one-tile ring of neighbours that see it
+local function refreshChunkMasks(index)
+    local x1, y1, x2, y2 = chunkTileRange(index)
+    refreshMasks(x1 - 1, y1 - 1, x2 + 1, y2 + 1)
+end
+
+-- Copies a chunk's raw tile bytes into the tile store. `data` is a
+-- string read from the level file, or a generated ByteData, which is
+-- read in place when the FFI is available.
+local function installChunk(index, data)
+    local cx, cy = chunkCoords(index)
+    local tiles, w = world.tiles, world.width
+    local x0, y0 = (cx - 1) * CHUNK, (cy - 1) * CHUNK
+    local cols = math.min(CHUNK, world.width - x0)
+    local rows = math.min(CHUNK, world.height - y0)
+    local byte = string.byte
+    local bytes
+    if type(data) ~= "string" then
+        if ffi then
+            bytes = ffi.cast("const uint8_t *", data:getFFIPointer())
+        else
+            data = data:getString()
+        end
+    end
+    for ly = 1, rows do
+        local row = (y0 + ly - 1) * w + x0
+        local base = (ly - 1) * CHUNK
+        for lx = 1, cols do
+            tiles[row + lx] = bytes and bytes[base + lx - 1] or byte(data, base + lx)
+        end
+    end
+    -- Runtime edits made before the chunk was last streamed out
+    local edits, original = world.edits[index], world.original
+    if edits then
+        for i, id in pairs(edits) do
+            original[i] = tiles[i]
+            tiles[i] = id
+        end
+    end
+    rebuildSolidChunk(index)
+    refreshChunkMasks(index)
+    world.resident[index] = true
+end
+
+local function removeChunkTiles(index)
+    local cx, cy = chunkCoords(index)
+    local tiles, w = world.tiles, world.width
+    local x0, y0 = (cx - 1) * CHUNK, (cy - 1) * CHUNK
+    local cols = math.min(CHUNK, world.width - x0)
+    local rows = math.min(CHUNK, world.height - y0)
+    for ly = 1, rows do
+        local row = (y0 + ly - 1) * w + x0
+        for lx = 1, cols do
+            tiles[row + lx] = NO_TILE
+        end
+    end
+    clearSolidChunk(index)
+    refreshChunkMasks(index)
+    world.resident[index] = nil
+end
+
+-- ======================
+-- TILE EDITING
+-- ======================
+-- Runtime changes go through setTile, which refreshes only what the
+-- tile feeds: its solidity bit, the runs of its row and column within
+-- the chunk, its autotile masks and its render batch. Edits
+-- are also kept per chunk, so a chunk that is streamed out and back in
+-- keeps them, and each edited tile remembers its level id, so edits are
+-- undone in memory without reading the level again.
+world.edits = {} -- [chunkIndex] = { [tileIndex] = id }
+world.original = {} -- [tileIndex] = level id of an edited tile, once its chunk has been loaded
+
+local function tileCoords(i)
+    return (i - 1) % world.width + 1, math.floor((i - 1) / world.width) + 1
+end
+
+-- Sets tile i as an edit, whether or not its chunk is loaded. Setting
+-- a tile back to its level id drops the edit.
+local function editTile(i, id)
+    local tx, ty = tileCoords(i)
+    local index = chunkIndex(chunkOfTile(tx, ty))
+    if world.resident[index] then
+        local current = world.tiles[i]
+        if current == id then return end
+        if world.original[i] == nil then
+            world.original[i] = current
+        end
+        world.tiles[i] = id
+        updateSolidTile(tx, ty)
+        refreshMasks(tx - 1, ty - 1, tx + 1, ty + 1)
+    end
+
+    local edits = world.edits[index]
+    if id == world.original[i] then
+        if edits then edits[i] = nil end
+        world.original[i] = nil
+    else
+        if not edits then
+            edits = {}
+            world.edits[index] = edits
+        end
+        edits[i] = id
     end
 end
 
--- Ground
-for x = 1, world.width do
-    for y = 35, world.height do
-        world.tiles[y][x] = 1
+-- Puts tile i back to its level id and drops its edit
+local function revertTile(i)
+    local original = world.original[i]
+    if original ~= nil then
+        editTile(i, original)
+    else
+        -- Not loaded since the edit was made, so only the edit is held
+        world.edits[chunkIndex(chunkOfTile(tileCoords(i)))][i] = nil
     end
 end
 
--- Boundaries
-for y = 1, world.height do
-    world.tiles[y][1] = 1
-    world.tiles[y][world.width] = 1
+local function setTile(tx, ty, id)
+    if not inBounds(tx, ty) or not world.resident[chunkIndex(chunkOfTile(tx, ty))] then return end
+    editTile(tileIndex(tx, ty), id)
+end
+
+local function breakTileAt(px, py)
+    local tx, ty = math.floor(px / TILE) + 1, math.floor(py / TILE) + 1
+    if getTile(tx, ty) == TILE_BREAKABLE then
+        setTile(tx, ty, TILE_EMPTY)
+    end
 end
 
--- Platforms
-for x = 10, 20 do world.tiles[30][x] = 1 end
-for x = 25, 35 do world.tiles[26][x] = 1 end
-for x = 40, 55 do world.tiles[28][x] = 1 end
-for x = 60, 75 do world.tiles[24][x] = 1 end
-for x = 80, 100 do world.tiles[29][x] = 1 end
+-- Drops every edit, putting loaded tiles back to their level ids
+local function revertTileEdits()
+    for index, edits in pairs(world.edits) do
+        for i in pairs(edits) do
+            revertTile(i)
+        end
+        world.edits[index] = nil
+    end
+end
 
--- Shafts
-for y = 20, 34 do world.tiles[y][22] = 1 end
-for y = 18, 34 do world.tiles[y][58] = 1 end
-for y = 15, 34 do world.tiles[y][78] = 1 end
+-- Moves the edits to exactly `target` ([tileIndex] = id), touching only
+-- the tiles that differ. `target` is emptied.
+local function applyTileEdits(target)
+    for _, edits in pairs(world.edits) do
+        for i in pairs(edits) do
+            if target[i] == nil then
+                revertTile(i)
+            end
+        end
+    end
+    for i, id in pairs(target) do
+        editTile(i, id)
+        target[i] = nil
+    end
+end
 
 -- ======================
 -- PLAYER
 -- ======================
-local player = {
-    x = 64, y = 64,
+-- Tuning; never changed by the simulation
+local playerConfig = {
     w = 20, h = 28,
-    vx = 0, vy = 0,
 
     speed = 260,
     accel = 2000,
@@ -62,31 +553,56 @@ local player = {
     jumpForce = 520,
     wallJumpForce = { x = 380, y = 520 },
 
+    coyoteTime = 0.1,
+    jumpBuffer = 0.12,
+
+    dashSpeed = 650,
+    dashTime = 0.18,
+    dashCooldown = 0.3
+}
+
+-- Runtime state. The box size is copied in so the player can be passed
+-- to code that takes any { x, y, w, h } body.
+local player = {
+    x = 64, y = 64,
+    prevX = 64, prevY = 64, -- position at the start of the last step
+    w = playerConfig.w, h = playerConfig.h,
+    vx = 0, vy = 0,
+
     grounded = false,
     onWall = false,
     wallDir = 0,
 
-    coyoteTime = 0.1,
     coyoteTimer = 0,
-
-    jumpBuffer = 0.12,
     jumpTimer = 0,
 
-    dashSpeed = 650,
-    dashTime = 0.18,
     dashTimer = 0,
-    dashCooldown = 0.3,
     dashCooldownTimer = 0,
     dashDir = 0,
+
+    facing = 1,
 }
 
+-- Fields that change at runtime, in snapshot order
+local PLAYER_STATE = {
+    "x", "y", "prevX", "prevY", "vx", "vy",
+    "grounded", "onWall", "wallDir",
+    "coyoteTimer", "jumpTimer", "dashTimer", "dashCooldownTimer", "dashDir",
+    "facing"
+}
+
+-- Starting values, restored by resetGame
+local playerStart = {}
+for k, v in pairs(player) do
+    playerStart[k] = v
+end
+
 -- ======================
 -- CAMERA
 -- ======================
-local camera = {
-    x = 0, y = 0,
-    smooth = 10
-}
+-- Headless runs (the benchmark) keep the default view size
+local camera = Camera.new(TILE, 1280, 720)
+camera:setBounds(world.width * TILE, world.height * TILE)
 
 -- ======================
 -- INPUT
@@ -96,9 +612,69 @@ local input = {
     right = false,
     jumpPressed = false,
     jumpHeld = false,
-    dashPressed = false
+    dashPressed = false,
+    firePressed = false
+}
+
+local KEY_ACTIONS = {
+    a = "left",
+    d = "right",
+    space = "jump",
+    lshift = "dash",
+    j = "fire"
+}
+
+-- Action changes wait here until the next simulation step, so they
+-- take effect on a well-defined tick (see feedInput)
+local inputQueue = {
+    count = 0,
+    actions = {},
+    downs = {}
 }
 
+local function applyAction(action, down)
+    if action == "left" then input.left = down end
+    if action == "right" then input.right = down end
+    if action == "jump" then
+        if down then input.jumpPressed = true end
+        input.jumpHeld = down
+    end
+    if action == "dash" and down then input.dashPressed = true end
+    if action == "fire" and down then input.firePressed = true end
+end
+
+-- Shared by the keyboard callbacks and scripted input
+local function handleKey(k, down)
+    local action = KEY_ACTIONS[k]
+    if action then
+        local n = inputQueue.count + 1
+        inputQueue.count = n
+        inputQueue.actions[n] = action
+        inputQueue.downs[n] = down
+    end
+end
+
+local function resetInput()
+    for k in pairs(input) do
+        input[k] = false
+    end
+    inputQueue.count = 0
+end
+
+-- Rebuilds held actions from the keyboard and drops pending presses.
+-- Used after jumping to another state (quickload, rewind), where the
+-- saved input no longer matches the keys actually down; queued events
+-- are dropped too, since isDown already reflects them.
+local function readHeldInput()
+    resetInput()
+    for key, action in pairs(KEY_ACTIONS) do
+        if love.keyboard.isDown(key) then
+            applyAction(action, true)
+        end
+    end
+    input.jumpPressed, input.dashPressed, input.firePressed = false, false, false
+end
+
 -- ======================
 -- UTILS
 -- ======================
@@ -106,41 +682,265 @@ local function sign(x) return x < 0 and -1 or x > 0 and 1 or 0 end
 local function clamp(x, a, b) return math.max(a, math.min(b, x)) end
 local function lerp(a, b, t) return a + (b - a) * t end
 
+-- ======================
+-- SIMULATION CLOCK
+-- ======================
+local sim = {
+    accumulator = 0,
+    alpha = 0, -- fraction of a step between the last two states
+    tick = 0, -- simulation steps since the last reset
+    seed = 1,
+    recording = nil, -- Replay recording in progress
+    playback = nil -- Replay cursor when playing a recording back
+}
+
+-- Position blended between the last two simulation steps
+local function renderPos(p)
+    return lerp(p.prevX, p.x, sim.alpha), lerp(p.prevY, p.y, sim.alpha)
+end
+
 -- ======================
 -- COLLISION
 -- ======================
+local function tileSolid(tx, ty)
+    if tx < 1 or ty < 1 or tx > world.width or ty > world.height then
+        return false
+    end
+    local x = tx - 1
+    return band(world.solidBits[(ty - 1) * ROW_WORDS + rshift(x, 5) + 1], lshift(1, band(x, 31))) ~= 0
+end
+
 local function solidAt(px, py)
-    local tx = math.floor(px / TILE) + 1
-    local ty = math.floor(py / TILE) + 1
-    if world.tiles[ty] and world.tiles[ty][tx] then
-        return world.tiles[ty][tx] == 1
+    return tileSolid(math.floor(px / TILE) + 1, math.floor(py / TILE) + 1)
+end
+
+-- First solid tile on row ty scanning right from `from` to `to`, or
+-- nil. Empty spans are skipped using the run cache; unloaded chunks
+-- count as empty and are skipped whole.
+local function firstSolidRight(ty, from, to)
+    if ty < 1 or ty > world.height then return nil end
+    local runsH, row = world.runsH, (ty - 1) * world.width
+    local tx = math.max(from, 1)
+    to = math.min(to, world.width)
+    while tx <= to do
+        local r = runsH[row + tx]
+        if r == NO_RUN then
+            tx = (math.floor((tx - 1) / CHUNK) + 1) * CHUNK + 1
+        else
+            local run = r % RUN_BASE
+            if run == 0 then return tx end
+            tx = tx + run
+        end
     end
-    return false
+    return nil
+end
+
+local function firstSolidLeft(ty, from, to)
+    if ty < 1 or ty > world.height then return nil end
+    local runsH, row = world.runsH, (ty - 1) * world.width
+    local tx = math.min(from, world.width)
+    to = math.max(to, 1)
+    while tx >= to do
+        local r = runsH[row + tx]
+        if r == NO_RUN then
+            tx = math.floor((tx - 1) / CHUNK) * CHUNK
+        else
+            local run = math.floor(r / RUN_BASE)
+            if run == 0 then return tx end
+            tx = tx - run
+        end
+    end
+    return nil
+end
+
+local function firstSolidDown(tx, from, to)
+    if tx < 1 or tx > world.width then return nil end
+    local runsV, w = world.runsV, world.width
+    local ty = math.max(from, 1)
+    to = math.min(to, world.height)
+    while ty <= to do
+        local r = runsV[(ty - 1) * w + tx]
+        if r == NO_RUN then
+            ty = (math.floor((ty - 1) / CHUNK) + 1) * CHUNK + 1
+        else
+            local run = r % RUN_BASE
+            if run == 0 then return ty end
+            ty = ty + run
+        end
+    end
+    return nil
+end
+
+local function firstSolidUp(tx, from, to)
+    if tx < 1 or tx > world.width then return nil end
+    local runsV, w = world.runsV, world.width
+    local ty = math.min(from, world.height)
+    to = math.max(to, 1)
+    while ty >= to do
+        local r = runsV[(ty - 1) * w + tx]
+        if r == NO_RUN then
+            ty = math.floor((ty - 1) / CHUNK) * CHUNK
+        else
+            local run = math.floor(r / RUN_BASE)
+            if run == 0 then return ty end
+            ty = ty - run
+        end
+    end
+    return nil
+end
+
+-- Swept box movement along one axis. Only the tile columns (or rows)
+-- the leading edge crosses are considered, and the box is snapped
+-- flush against the nearest solid one, so the result does not depend
+-- on the step size. Each spanned row (or column) is scanned with the
+-- run cache, and later scans stop short of the nearest hit so far.
+-- A box spans tiles floor(a / TILE) + 1 .. ceil((a + len) / TILE).
+local function sweepX(x, y, w, h, dx)
+    if dx == 0 then return x, false end
+    local ty1 = math.floor(y / TILE) + 1
+    local ty2 = math.ceil((y + h) / TILE)
+
+    if dx > 0 then
+        local from, to = math.ceil((x + w) / TILE) + 1, math.ceil((x + w + dx) / TILE)
+        for ty = ty1, ty2 do
+            local tx = firstSolidRight(ty, from, to)
+            if tx then to = tx - 1 end
+        end
+        if to < math.ceil((x + w + dx) / TILE) then
+            return to * TILE - w, true
+        end
+    else
+        local from, to = math.floor(x / TILE), math.floor((x + dx) / TILE) + 1
+        for ty = ty1, ty2 do
+            local tx = firstSolidLeft(ty, from, to)
+            if tx then to = tx + 1 end
+        end
+        if to > math.floor((x + dx) / TILE) + 1 then
+            return (to - 1) * TILE, true
+        end
+    end
+    return x + dx, false
+end
+
+local function sweepY(x, y, w, h, dy)
+    if dy == 0 then return y, false end
+    local tx1 = math.floor(x / TILE) + 1
+    local tx2 = math.ceil((x + w) / TILE)
+
+    if dy > 0 then
+        local from, to = math.ceil((y + h) / TILE) + 1, math.ceil((y + h + dy) / TILE)
+        for tx = tx1, tx2 do
+            local ty = firstSolidDown(tx, from, to)
+            if ty then to = ty - 1 end
+        end
+        if to < math.ceil((y + h + dy) / TILE) then
+            return to * TILE - h, true
+        end
+    else
+        local from, to = math.floor(y / TILE), math.floor((y + dy) / TILE) + 1
+        for tx = tx1, tx2 do
+            local ty = firstSolidUp(tx, from, to)
+            if ty then to = ty + 1 end
+        end
+        if to > math.floor((y + dy) / TILE) + 1 then
+            return (to - 1) * TILE, true
+        end
+    end
+    return y + dy, false
+end
+
+-- ======================
+-- RAYCAST
+-- ======================
+-- Grid traversal (Amanatides & Woo): steps from cell to cell along the
+-- ray, visiting each crossed tile exactly once. (dx, dy) need not be
+-- normalised. Returns hit, tx, ty, nx, ny, dist where (nx, ny) is the
+-- normal of the tile face that was hit; a ray starting inside a solid
+-- tile hits at distance 0 with a zero normal.
+local function raycast(x0, y0, dx, dy, maxDist)
+    local len = math.sqrt(dx * dx + dy * dy)
+    if len == 0 then return false, nil, nil, 0, 0, 0 end
+    dx, dy = dx / len, dy / len
+
+    local tx = math.floor(x0 / TILE) + 1
+    local ty = math.floor(y0 / TILE) + 1
+    if tileSolid(tx, ty) then
+        return true, tx, ty, 0, 0, 0
+    end
+
+    local stepX = dx > 0 and 1 or -1
+    local stepY = dy > 0 and 1 or -1
+    local huge = math.huge
+    local deltaX = dx ~= 0 and TILE / math.abs(dx) or huge
+    local deltaY = dy ~= 0 and TILE / math.abs(dy) or huge
+    local maxX, maxY = huge, huge
+    if dx > 0 then
+        maxX = (tx * TILE - x0) / dx
+    elseif dx < 0 then
+        maxX = ((tx - 1) * TILE - x0) / dx
+    end
+    if dy > 0 then
+        maxY = (ty * TILE - y0) / dy
+    elseif dy < 0 then
+        maxY = ((ty - 1) * TILE - y0) / dy
+    end
+
+    local width, height = world.width, world.height
+    while true do
+        local dist, nx, ny
+        if maxX < maxY then
+            dist = maxX
+            tx = tx + stepX
+            maxX = maxX + deltaX
+            nx, ny = -stepX, 0
+        else
+            dist = maxY
+            ty = ty + stepY
+            maxY = maxY + deltaY
+            nx, ny = 0, -stepY
+        end
+        if dist > maxDist then break end
+        -- Nothing solid outside the world
+        if (tx < 1 and stepX < 0) or (tx > width and stepX > 0)
+            or (ty < 1 and stepY < 0) or (ty > height and stepY > 0) then
+            break
+        end
+        if tileSolid(tx, ty) then
+            return true, tx, ty, nx, ny, dist
+        end
+    end
+    return false, nil, nil, 0, 0, maxDist
 end
 
-local function rectCollides(x, y, w, h)
-    return solidAt(x, y)
-        or solidAt(x + w, y)
-        or solidAt(x, y + h)
-        or solidAt(x + w, y + h)
+-- Casts rays[i] for i = 1..n. Both tables are struct-of-arrays:
+--   rays: x, y, dx, dy, maxDist
+--   hits: hit, tx, ty, nx, ny, dist (filled in; tx/ty are false on a miss)
+-- so casting a batch every frame does not allocate.
+local function raycastBatch(rays, n, hits)
+    local rx, ry, rdx, rdy, rmax = rays.x, rays.y, rays.dx, rays.dy, rays.maxDist
+    local hit, htx, hty, hnx, hny, hdist = hits.hit, hits.tx, hits.ty, hits.nx, hits.ny, hits.dist
+    for i = 1, n do
+        local h, tx, ty, nx, ny, dist = raycast(rx[i], ry[i], rdx[i], rdy[i], rmax[i])
+        hit[i], htx[i], hty[i] = h, tx or false, ty or false
+        hnx[i], hny[i], hdist[i] = nx, ny, dist
+    end
 end
 
 -- ======================
 -- MOVEMENT
 -- ======================
 local function moveAndCollide(p, dt)
-    p.x = p.x + p.vx * dt
-    if rectCollides(p.x, p.y, p.w, p.h) then
-        p.x = p.x - p.vx * dt
+    local hit
+    p.x, hit = sweepX(p.x, p.y, p.w, p.h, p.vx * dt)
+    if hit then
         p.vx = 0
     end
 
-    p.y = p.y + p.vy * dt
-    if rectCollides(p.x, p.y, p.w, p.h) then
-        p.y = p.y - p.vy * dt
+    p.y, hit = sweepY(p.x, p.y, p.w, p.h, p.vy * dt)
+    if hit then
         if p.vy > 0 then
             p.grounded = true
-            p.coyoteTimer = p.coyoteTime
+            p.coyoteTimer = playerConfig.coyoteTime
         end
         p.vy = 0
     else
@@ -149,50 +949,399 @@ local function moveAndCollide(p, dt)
 end
 
 -- ======================
--- PLAYER UPDATE
+-- PARTICLES
 -- ======================
-local function updatePlayer(p, dt)
-    p.coyoteTimer = p.coyoteTimer - dt
-    p.jumpTimer = p.jumpTimer - dt
-    p.dashCooldownTimer = p.dashCooldownTimer - dt
+-- Short-lived effects (dust, sparks) are tables recycled through a
+-- preallocated pool, so spawning them during play does not allocate.
+-- When the pool runs dry (or the quality limit is reached) new
+-- particles are skipped and counted for the profiler overlay.
+local particles = {
+    pool = Pool.new(function()
+        return { x = 0, y = 0, vx = 0, vy = 0, life = 0, maxLife = 0, size = 0, gravity = 0 }
+    end, PARTICLE_CAPACITY),
+    active = {},
+    count = 0,
+    dropped = 0, -- emits skipped at the limit or with the pool empty
+    limit = PARTICLE_CAPACITY -- live particles allowed, lowered by the quality scaler
+}
 
-    p.onWall = false
-    p.wallDir = 0
-    if solidAt(p.x - 1, p.y + p.h / 2) then
-        p.onWall = true
-        p.wallDir = -1
-    elseif solidAt(p.x + p.w + 1, p.y + p.h / 2) then
-        p.onWall = true
-        p.wallDir = 1
+local function emitParticle(x, y, vx, vy, life, size, gravity)
+    local pt = particles.count < particles.limit and particles.pool:acquire()
+    if not pt then
+        particles.dropped = particles.dropped + 1
+        return
     end
+    pt.x, pt.y = x, y
+    pt.vx, pt.vy = vx, vy
+    pt.life, pt.maxLife = life, life
+    pt.size = size
+    pt.gravity = gravity
+    local n = particles.count + 1
+    particles.active[n] = pt
+    particles.count = n
+end
 
-    if input.left then
-        p.vx = p.vx - p.accel * dt
-    elseif input.right then
-        p.vx = p.vx + p.accel * dt
-    else
-        p.vx = p.vx - math.min(math.abs(p.vx), p.friction * dt) * sign(p.vx)
+-- `count` particles spread around the direction (dirX, dirY)
+local function emitBurst(x, y, count, speed, dirX, dirY, spread, life, gravity)
+    local random = love.math.random
+    local base = math.atan2(dirY, dirX)
+    for _ = 1, count do
+        local angle = base + (random() - 0.5) * spread
+        local v = speed * (0.5 + random() * 0.5)
+        emitParticle(x, y, math.cos(angle) * v, math.sin(angle) * v,
+            life * (0.6 + random() * 0.4), 2 + random() * 2, gravity)
     end
-    p.vx = clamp(p.vx, -p.speed, p.speed)
+end
 
-    if p.dashTimer <= 0 then
-        p.vy = clamp(p.vy + GRAVITY * dt, -9999, MAX_FALL)
+local function updateParticles(dt)
+    local active = particles.active
+    local i = 1
+    while i <= particles.count do
+        local pt = active[i]
+        pt.life = pt.life - dt
+        if pt.life <= 0 then
+            local last = particles.count
+            active[i] = active[last]
+            active[last] = nil
+            particles.count = last - 1
+            particles.pool:release(pt)
+        else
+            pt.vy = pt.vy + pt.gravity * dt
+            pt.x = pt.x + pt.vx * dt
+            pt.y = pt.y + pt.vy * dt
+            i = i + 1
+        end
     end
+end
 
-    if input.jumpPressed then
-        p.jumpTimer = p.jumpBuffer
+local function clearParticles()
+    local active = particles.active
+    for i = particles.count, 1, -1 do
+        particles.pool:release(active[i])
+        active[i] = nil
     end
+    particles.count = 0
+end
 
-    if p.jumpTimer > 0 then
-        if p.coyoteTimer > 0 then
-            p.vy = -p.jumpForce
-            p.jumpTimer = 0
-            p.coyoteTimer = 0
-        elseif p.onWall then
-            p.vx = -p.wallDir * p.wallJumpForce.x
-            p.vy = -p.wallJumpForce.y
-            p.jumpTimer = 0
-        end
+-- ======================
+-- ENTITIES
+-- ======================
+-- Enemies and projectiles are stored as parallel arrays indexed
+-- 1..count (C arrays on the FFI path). Removal swaps the last entity
+-- into the freed slot, so the arrays stay dense and spawning never
+-- allocates; slots past count are stale. Spawns past ENTITY_CAPACITY
+-- are dropped, like particles, and counted for the profiler overlay.
+local ENTITY_ENEMY = 1
+local ENTITY_PROJECTILE = 2
+local ENTITY_CAPACITY = 1024
+
+-- Column name and its C type
+local ENTITY_FIELDS = {
+    { "kind", "uint8_t" },
+    { "x", "double" }, { "y", "double" },
+    { "prevX", "double" }, { "prevY", "double" },
+    { "w", "double" }, { "h", "double" },
+    { "vx", "double" }, { "vy", "double" },
+    { "gravity", "bool" }, { "grounded", "bool" },
+    { "life", "double" }, { "pending", "double" }
+}
+
+local ENEMY_AGGRO_RADIUS = 6 * TILE
+
+-- Activity regions, measured from the edge of a SIM_VIEW_W x SIM_VIEW_H
+-- view centred on the player. The size is fixed rather than the
+-- camera's, which changes with the window, low resolution and quality.
+local SIM_VIEW_W, SIM_VIEW_H = 1280, 720
+local ACTIVE_RANGE = 4 * TILE -- simulated every step
+local REDUCED_RANGE = 24 * TILE -- simulated every REDUCED_INTERVAL steps
+local REDUCED_INTERVAL = 4
+local MAX_CATCHUP = 2 -- seconds of missed time replayed on waking
+local CATCHUP_STEP = 1 / 30 -- largest step used to replay missed time
+
+-- Scales both ranges; lowered by the quality scaler
+local activity = { scale = 1 }
+
+local entities = {
+    count = 0,
+    dropped = 0, -- spawns refused at ENTITY_CAPACITY
+    grid = SpatialHash.new(TILE * 2) -- broadphase over entity boxes
+}
+for _, field in ipairs(ENTITY_FIELDS) do
+    entities[field[1]] = newArray(field[2], ENTITY_CAPACITY)
+end
+
+local function spawnEntity(kind, x, y, w, h, vx, vy, gravity, life)
+    local e = entities
+    local i = e.count + 1
+    if i > ENTITY_CAPACITY then
+        e.dropped = e.dropped + 1
+        return nil
+    end
+    e.count = i
+    e.kind[i] = kind
+    e.x[i], e.y[i] = x, y
+    e.prevX[i], e.prevY[i] = x, y
+    e.w[i], e.h[i] = w, h
+    e.vx[i], e.vy[i] = vx, vy
+    e.gravity[i] = gravity
+    e.grounded[i] = false
+    e.life[i] = life or math.huge
+    e.pending[i] = 0
+    e.grid:insert(i, x, y, w, h)
+    return i
+end
+
+local function removeEntity(i)
+    local e = entities
+    local last = e.count
+    e.grid:remove(i)
+    e.grid:rename(last, i)
+    for _, field in ipairs(ENTITY_FIELDS) do
+        local column = e[field[1]]
+        column[i] = column[last]
+    end
+    e.count = last - 1
+end
+
+local function spawnEnemy(tx, ty, dir)
+    return spawnEntity(ENTITY_ENEMY, (tx - 1) * TILE + 6, (ty - 1) * TILE - 24,
+        20, 24, dir * 80, 0, true)
+end
+
+local function spawnProjectile(x, y, dir)
+    return spawnEntity(ENTITY_PROJECTILE, x - 4, y - 2, 8, 4, dir * 700, 0, false, 1.5)
+end
+
+-- Reused by broadphase queries so they do not allocate
+local queryResults = {}
+
+-- Line-of-sight rays for the aggro pass, cast with raycastBatch
+local sightRays = { x = {}, y = {}, dx = {}, dy = {}, maxDist = {}, entity = {} }
+local sightHits = { hit = {}, tx = {}, ty = {}, nx = {}, ny = {}, dist = {} }
+
+-- Integrates one entity by dt with the same swept tile collision as
+-- the player
+local function stepEntity(i, dt)
+    local e = entities
+    local kind, x, y, w, h = e.kind, e.x, e.y, e.w, e.h
+    local vx, vy, grounded, life = e.vx, e.vy, e.grounded, e.life
+
+    if e.gravity[i] then
+        vy[i] = math.min(vy[i] + GRAVITY * dt, MAX_FALL)
+    end
+
+    local hitX, hitY
+    x[i], hitX = sweepX(x[i], y[i], w[i], h[i], vx[i] * dt)
+    y[i], hitY = sweepY(x[i], y[i], w[i], h[i], vy[i] * dt)
+    life[i] = life[i] - dt
+
+    if kind[i] == ENTITY_PROJECTILE then
+        if hitX or hitY then
+            life[i] = 0
+            local ahead = vx[i] > 0 and x[i] + w[i] + 1 or x[i] - 1
+            breakTileAt(ahead, y[i] + h[i] / 2)
+        end
+    else
+        if hitY then
+            grounded[i] = vy[i] > 0
+            vy[i] = 0
+        else
+            grounded[i] = false
+        end
+
+        -- Walkers turn around at walls and ledges
+        local ahead = vx[i] > 0 and x[i] + w[i] + 1 or x[i] - 1
+        if hitX or (grounded[i] and not solidAt(ahead, y[i] + h[i] + 1)) then
+            vx[i] = -vx[i]
+        end
+    end
+
+    e.grid:update(i, x[i], y[i], w[i], h[i])
+end
+
+-- Runs the simulation time an entity is owed, in steps no longer
+-- than CATCHUP_STEP
+local function settleEntity(i)
+    local owed = entities.pending[i]
+    local steps = math.ceil(owed / CATCHUP_STEP)
+    for _ = 1, steps do
+        stepEntity(i, owed / steps)
+    end
+    entities.pending[i] = 0
+end
+
+-- Batch update over every entity. Each entity is owed dt per step and
+-- is settled according to its distance from the view: every step when
+-- close, every REDUCED_INTERVAL steps (staggered by slot) further out,
+-- and not at all beyond that or on chunks that are not loaded. Owed
+-- time is capped at MAX_CATCHUP and replayed in a few large steps once
+-- the entity comes back, so the cost tracks what is near the player.
+-- Entities that die are flagged with life <= 0 and compacted out at
+-- the end of the step.
+local function updateEntities(dt)
+    local e = entities
+    local grid = e.grid
+    local kind, x, y, w, h = e.kind, e.x, e.y, e.w, e.h
+    local vx, grounded, life = e.vx, e.grounded, e.life
+    local prevX, prevY, pending = e.prevX, e.prevY, e.pending
+
+    -- Enemies that can see a nearby player turn to face them. Each
+    -- candidate gets a ray towards the player and they are cast in one
+    -- batch.
+    local px, py = player.x + player.w / 2, player.y + player.h / 2
+    local n = grid:queryRadius(px, py, ENEMY_AGGRO_RADIUS, queryResults)
+    local rays, rayCount = sightRays, 0
+    for k = 1, n do
+        local j = queryResults[k]
+        if kind[j] == ENTITY_ENEMY and grounded[j] then
+            local ex, ey = x[j] + w[j] / 2, y[j] + h[j] / 2
+            local dx, dy = px - ex, py - ey
+            rayCount = rayCount + 1
+            rays.x[rayCount], rays.y[rayCount] = ex, ey
+            rays.dx[rayCount], rays.dy[rayCount] = dx, dy
+            rays.maxDist[rayCount] = math.sqrt(dx * dx + dy * dy)
+            rays.entity[rayCount] = j
+        end
+    end
+    raycastBatch(rays, rayCount, sightHits)
+    for r = 1, rayCount do
+        local dir = sign(rays.dx[r])
+        if not sightHits.hit[r] and dir ~= 0 then
+            local j = rays.entity[r]
+            vx[j] = dir * math.abs(vx[j])
+        end
+    end
+
+    -- The view is centred on the player rather than read from the
+    -- smoothed camera, which moves per frame and would make activity
+    -- (and so replays) depend on the frame rate
+    local left, top = px - SIM_VIEW_W / 2, py - SIM_VIEW_H / 2
+    local right, bottom = left + SIM_VIEW_W, top + SIM_VIEW_H
+    local tick = sim.tick
+
+    -- Recordings always run at full range, so the quality settings of
+    -- the machine cannot change how they play back
+    local scale = (sim.recording or sim.playback) and 1 or activity.scale
+    local activeRange, reducedRange = ACTIVE_RANGE * scale, REDUCED_RANGE * scale
+
+    for i = 1, e.count do
+        prevX[i], prevY[i] = x[i], y[i]
+        pending[i] = pending[i] + dt
+
+        local cx, cy = x[i] + w[i] / 2, y[i] + h[i] / 2
+        local dist = math.max(left - cx, cx - right, top - cy, cy - bottom, 0)
+        if dist > reducedRange or not isResidentAt(cx, cy) then
+            pending[i] = math.min(pending[i], MAX_CATCHUP)
+        elseif dist <= activeRange or (tick + i) % REDUCED_INTERVAL == 0 then
+            local waking = pending[i] > dt * 1.5
+            settleEntity(i)
+            if waking then
+                -- Do not interpolate across the catch-up
+                prevX[i], prevY[i] = x[i], y[i]
+            end
+        end
+    end
+
+    -- Projectile hits. Query order follows the hash's cells, which
+    -- depends on insertion history, so the lowest-index enemy is the
+    -- one hit; restored and replayed runs then pick the same target.
+    for i = 1, e.count do
+        if kind[i] == ENTITY_PROJECTILE and life[i] > 0 then
+            n = grid:queryRect(x[i], y[i], w[i], h[i], queryResults)
+            local target = nil
+            for k = 1, n do
+                local j = queryResults[k]
+                if kind[j] == ENTITY_ENEMY and life[j] > 0 and (not target or j < target) then
+                    target = j
+                end
+            end
+            if target then
+                life[i] = 0
+                life[target] = 0
+            end
+        end
+    end
+
+    -- Walking backwards keeps swap-remove from skipping anyone
+    for i = e.count, 1, -1 do
+        if life[i] <= 0 then
+            if kind[i] == ENTITY_PROJECTILE then
+                emitBurst(x[i] + w[i] / 2, y[i] + h[i] / 2, 6, 160, -sign(vx[i]), 0, 2.5, 0.25, 0)
+            end
+            removeEntity(i)
+        end
+    end
+end
+
+local function spawnWorldEntities()
+    spawnEnemy(15, 30, 1)
+    spawnEnemy(30, 26, -1)
+    spawnEnemy(47, 28, 1)
+    spawnEnemy(67, 24, -1)
+    spawnEnemy(90, 29, 1)
+    spawnEnemy(40, 35, -1)
+    spawnEnemy(100, 35, 1)
+end
+
+local function clearEntities()
+    while entities.count > 0 do
+        removeEntity(entities.count)
+    end
+end
+
+spawnWorldEntities()
+
+-- ======================
+-- PLAYER UPDATE
+-- ======================
+local function updatePlayer(p, dt)
+    local cfg = playerConfig
+    p.coyoteTimer = p.coyoteTimer - dt
+    p.jumpTimer = p.jumpTimer - dt
+    p.dashCooldownTimer = p.dashCooldownTimer - dt
+
+    p.onWall = false
+    p.wallDir = 0
+    if solidAt(p.x - 1, p.y + p.h / 2) then
+        p.onWall = true
+        p.wallDir = -1
+    elseif solidAt(p.x + p.w + 1, p.y + p.h / 2) then
+        p.onWall = true
+        p.wallDir = 1
+    end
+
+    if input.left then
+        p.vx = p.vx - cfg.accel * dt
+        p.facing = -1
+    elseif input.right then
+        p.vx = p.vx + cfg.accel * dt
+        p.facing = 1
+    else
+        p.vx = p.vx - math.min(math.abs(p.vx), cfg.friction * dt) * sign(p.vx)
+    end
+    p.vx = clamp(p.vx, -cfg.speed, cfg.speed)
+
+    if p.dashTimer <= 0 then
+        p.vy = clamp(p.vy + GRAVITY * dt, -9999, MAX_FALL)
+    end
+
+    if input.jumpPressed then
+        p.jumpTimer = cfg.jumpBuffer
+    end
+
+    if p.jumpTimer > 0 then
+        if p.coyoteTimer > 0 then
+            p.vy = -cfg.jumpForce
+            p.jumpTimer = 0
+            p.coyoteTimer = 0
+            emitBurst(p.x + p.w / 2, p.y + p.h, 6, 90, 0, -1, 2.4, 0.3, 300)
+        elseif p.onWall then
+            p.vx = -p.wallDir * cfg.wallJumpForce.x
+            p.vy = -cfg.wallJumpForce.y
+            p.jumpTimer = 0
+            local wallX = p.wallDir > 0 and p.x + p.w or p.x
+            emitBurst(wallX, p.y + p.h / 2, 6, 100, -p.wallDir, 0, 1.6, 0.3, 300)
+        end
     end
 
     if not input.jumpHeld and p.vy < 0 then
@@ -204,88 +1353,1373 @@ local function updatePlayer(p, dt)
     end
 
     if input.dashPressed and p.dashCooldownTimer <= 0 then
-        p.dashTimer = p.dashTime
-        p.dashCooldownTimer = p.dashCooldown
+        p.dashTimer = cfg.dashTime
+        p.dashCooldownTimer = cfg.dashCooldown
         p.dashDir = sign(p.vx)
         if p.dashDir == 0 then p.dashDir = 1 end
+        emitBurst(p.x + p.w / 2, p.y + p.h / 2, 8, 140, -p.dashDir, 0, 1.2, 0.25, 0)
     end
 
     if p.dashTimer > 0 then
         p.dashTimer = p.dashTimer - dt
-        p.vx = p.dashDir * p.dashSpeed
+        p.vx = p.dashDir * cfg.dashSpeed
         p.vy = 0
+        emitParticle(p.x + p.w / 2, p.y + love.math.random() * p.h, 0, 0, 0.2, 3, 0)
     end
 
+    local wasGrounded = p.grounded
+    local fallSpeed = p.vy
     moveAndCollide(p, dt)
 
+    if p.grounded and not wasGrounded and fallSpeed > 300 then
+        emitBurst(p.x + p.w / 2, p.y + p.h, 10, fallSpeed * 0.2, 0, -1, 3, 0.35, 300)
+    end
+
+    if input.firePressed then
+        spawnProjectile(p.x + p.w / 2 + p.facing * p.w / 2, p.y + p.h / 2, p.facing)
+    end
+
     input.jumpPressed = false
     input.dashPressed = false
+    input.firePressed = false
 end
 
 -- ======================
 -- CAMERA UPDATE
 -- ======================
 local function updateCamera(dt)
-    local screenW, screenH = love.graphics.getDimensions()
+    local px, py = renderPos(player)
+    camera:update(dt, px + player.w / 2, py + player.h / 2, player.vx)
+end
 
-    local targetX = player.x + player.w / 2 - screenW / 2
-    local targetY = player.y + player.h / 2 - screenH / 2
+local function snapCamera()
+    camera:snap(player.x + player.w / 2, player.y + player.h / 2)
+end
 
-    camera.x = lerp(camera.x, targetX, camera.smooth * dt)
-    camera.y = lerp(camera.y, targetY, camera.smooth * dt)
+-- ======================
+-- TILE RENDERER
+-- ======================
+-- The world is split into CHUNK x CHUNK tile chunks, each owning a
+-- SpriteBatch of its solid tiles. Chunks are built on first sight and
+-- only rebuilt when one of their tiles changes. Every (tile id, autotile
+-- mask) pair is a quad in one tileset atlas, keyed id * 256 + mask, so
+-- a chunk draws in one call whatever it holds.
 
-    -- Clamp to world bounds
-    camera.x = clamp(camera.x, 0, world.width * TILE - screenW)
-    camera.y = clamp(camera.y, 0, world.height * TILE - screenH)
+-- Stand-in tile art, painted at startup: base colour, bevels on the
+-- sides that do not connect, and an optional crack pattern
+local TILE_ART = {
+    [TILE_SOLID] = { color = { 0.62, 0.66, 0.74 } },
+    [TILE_BREAKABLE] = { color = { 0.75, 0.55, 0.4 }, cracked = true }
+}
+
+local render = {
+    tileset = nil, -- built once every image in `art` has loaded
+    art = nil, -- [quad key] = asset handle, while loading
+    artSpecs = nil, -- [quad key] = TileArt spec the handle was loaded from
+    chunks = {} -- [chunkIndex] = { batch, count, dirty }
+}
+
+-- Chunk range covering the view plus `margin` tiles, clamped to the world
+local function viewChunkRange(margin)
+    local x1 = math.max(1, camera.tileX1 - margin)
+    local y1 = math.max(1, camera.tileY1 - margin)
+    local x2 = math.min(world.width, camera.tileX2 + margin)
+    local y2 = math.min(world.height, camera.tileY2 + margin)
+    return math.floor((x1 - 1) / CHUNK) + 1, math.floor((y1 - 1) / CHUNK) + 1,
+        math.floor((x2 - 1) / CHUNK) + 1, math.floor((y2 - 1) / CHUNK) + 1
+end
+
+local function buildChunk(cx, cy)
+    local index = chunkIndex(cx, cy)
+    local chunk = render.chunks[index]
+    if not chunk then
+        chunk = {
+            batch = love.graphics.newSpriteBatch(render.tileset.image, CHUNK * CHUNK, "static"),
+            count = 0,
+            dirty = true
+        }
+        render.chunks[index] = chunk
+    end
+
+    local batch = chunk.batch
+    batch:clear()
+
+    local quads = render.tileset.quads
+    local tiles, masks, w = world.tiles, world.masks, world.width
+    local x1, y1, x2, y2 = chunkTileRange(index)
+    for ty = y1, y2 do
+        local row = (ty - 1) * w
+        for tx = x1, x2 do
+            local i = row + tx
+            local quad = masks[i] and quads[tiles[i] * 256 + masks[i]]
+            if quad then
+                batch:add(quad, (tx - 1) * TILE, (ty - 1) * TILE)
+            end
+        end
+    end
+
+    chunk.count = batch:getCount()
+    chunk.dirty = false
+    return chunk
+end
+
+function markChunkDirty(index)
+    local chunk = render.chunks[index]
+    if chunk then
+        chunk.dirty = true
+    end
+end
+
+-- Tile images are painted on the asset workers; the atlas is built
+-- once they have all arrived (see updateTileRenderer)
+local function initTileRenderer()
+    render.art, render.artSpecs = {}, {}
+    for id, art in pairs(TILE_ART) do
+        for mask = 0, 255 do
+            if AUTOTILE_REDUCE[mask] == mask then
+                local key = id * 256 + mask
+                local r, g, b = unpack(art.color)
+                local spec = { size = TILE, r = r, g = g, b = b, cracked = art.cracked or false, mask = mask }
+                render.artSpecs[key] = spec
+                render.art[key] = Assets.load("tileart", spec, "tileart:" .. key)
+            end
+        end
+    end
+end
+
+local function updateTileRenderer()
+    if render.tileset or not render.art then return end
+    for _, handle in pairs(render.art) do
+        if handle.state == "loading" then return end
+    end
+
+    -- A tile the workers failed to paint is painted here instead, so
+    -- every (id, mask) pair has a quad
+    local tileset = Tileset.new(TILE, 2)
+    local painted = {}
+    for key, handle in pairs(render.art) do
+        if handle.state == "ready" then
+            tileset:add(key, handle.value)
+        else
+            painted[key] = TileArt.paint(render.artSpecs[key])
+            tileset:add(key, painted[key])
+        end
+    end
+    tileset:build()
+    for _, handle in pairs(render.art) do
+        Assets.release(handle)
+    end
+    for _, data in pairs(painted) do
+        data:release()
+    end
+    render.art, render.artSpecs = nil, nil
+    render.tileset = tileset
+end
+
+local function drawTiles()
+    if not render.tileset then return end
+
+    -- Only visit chunks inside the view (plus a margin), so the cost
+    -- depends on screen size rather than world size
+    local cx1, cy1, cx2, cy2 = viewChunkRange(DRAW_MARGIN)
+
+    for cy = cy1, cy2 do
+        for cx = cx1, cx2 do
+            local chunk = render.chunks[chunkIndex(cx, cy)]
+            if not chunk or chunk.dirty then
+                chunk = buildChunk(cx, cy)
+            end
+            if chunk.count > 0 then
+                love.graphics.draw(chunk.batch)
+            end
+        end
+    end
+end
+
+local function drawParticles()
+    local active = particles.active
+    for i = 1, particles.count do
+        local pt = active[i]
+        love.graphics.setColor(1, 1, 1, pt.life / pt.maxLife)
+        love.graphics.rectangle("fill", pt.x - pt.size / 2, pt.y - pt.size / 2, pt.size, pt.size)
+    end
+    love.graphics.setColor(1, 1, 1)
+end
+
+-- F2 outlines the merged collision rectangles of the visible chunks,
+-- building any that are missing or stale
+local showCollisionRects = false
+
+local function drawCollisionRects()
+    if not showCollisionRects then return end
+    local cx1, cy1, cx2, cy2 = viewChunkRange(0)
+    love.graphics.setColor(0.3, 0.8, 1, 0.8)
+    for cy = cy1, cy2 do
+        for cx = cx1, cx2 do
+            local index = chunkIndex(cx, cy)
+            local rects = world.rects[index]
+            if world.resident[index] and (not rects or rects.stale) then
+                rebuildChunkRects(index)
+                rects = world.rects[index]
+            end
+            if rects then
+                for i = 1, rects.n * RECT_STRIDE, RECT_STRIDE do
+                    love.graphics.rectangle("line", (rects[i] - 1) * TILE + 0.5,
+                        (rects[i + 1] - 1) * TILE + 0.5, rects[i + 2] * TILE - 1, rects[i + 3] * TILE - 1)
+                end
+            end
+        end
+    end
+    love.graphics.setColor(1, 1, 1)
+end
+
+local function drawEntities()
+    local left, top = camera.x, camera.y
+    local right, bottom = left + camera.viewW, top + camera.viewH
+
+    local e = entities
+    local alpha = sim.alpha
+    for i = 1, e.count do
+        local x = lerp(e.prevX[i], e.x[i], alpha)
+        local y = lerp(e.prevY[i], e.y[i], alpha)
+        local w, h = e.w[i], e.h[i]
+        if x + w >= left and x <= right and y + h >= top and y <= bottom then
+            if e.kind[i] == ENTITY_PROJECTILE then
+                love.graphics.setColor(1, 0.9, 0.3)
+            else
+                love.graphics.setColor(0.85, 0.3, 0.3)
+            end
+            love.graphics.rectangle("fill", x, y, w, h)
+        end
+    end
+    love.graphics.setColor(1, 1, 1)
 end
 
 -- ======================
--- LOVE
+-- BACKGROUND LAYERS
 -- ======================
-function love.load()
-    love.window.setMode(1280, 720)
+-- Decorative parallax layers never change, so each is baked once into
+-- LAYER_TILE-sized canvases on first sight and afterwards only blitted
+-- at its scrolled offset. Canvases that scroll well out of view are
+-- released. The tile layer needs no canvas: its chunk SpriteBatches are
+-- already static geometry.
+local backgroundLayers = {
+    { parallax = 0.2, color = { 0.09, 0.10, 0.15 }, seed = 11, slot = 128, tiles = {} },
+    { parallax = 0.45, color = { 0.14, 0.15, 0.21 }, seed = 23, slot = 64, tiles = {} }
+}
+
+-- Layers drawn, nearest first dropped; lowered by the quality scaler
+local layerCount = #backgroundLayers
+
+local function releaseLayerTiles(layer)
+    for key, tile in pairs(layer.tiles) do
+        tile.canvas:release()
+        layer.tiles[key] = nil
+    end
 end
 
-function love.update(dt)
-    updatePlayer(player, dt)
-    updateCamera(dt)
+local function setLayerCount(n)
+    layerCount = n
+    for i = n + 1, #backgroundLayers do
+        releaseLayerTiles(backgroundLayers[i])
+    end
 end
 
-function love.draw()
-    love.graphics.push()
-    love.graphics.translate(-camera.x, -camera.y)
-
-    for y = 1, world.height do
-        for x = 1, world.width do
-            if world.tiles[y][x] == 1 then
-                love.graphics.rectangle(
-                    "fill",
-                    (x - 1) * TILE,
-                    (y - 1) * TILE,
-                    TILE, TILE
-                )
+-- Layer content is a row of pillars, one per `slot` pixels (a divisor
+-- of LAYER_TILE), with heights from noise. It is a pure function of
+-- layer position, so tiles bake independently and still join without
+-- seams.
+local function bakeLayerTile(layer, ix, iy)
+    local canvas = love.graphics.newCanvas(LAYER_TILE, LAYER_TILE)
+    local ox, oy = ix * LAYER_TILE, iy * LAYER_TILE
+
+    love.graphics.push("all")
+    love.graphics.setCanvas(canvas)
+    love.graphics.clear(0, 0, 0, 0)
+    love.graphics.origin()
+    love.graphics.setColor(layer.color)
+    for k = ox / layer.slot, (ox + LAYER_TILE) / layer.slot - 1 do
+        local n = love.math.noise(k * 0.31, layer.seed)
+        local w = layer.slot * (0.3 + 0.5 * love.math.noise(k * 0.77, layer.seed + 0.5))
+        local top = LAYER_BASE_Y + (1 - n) * LAYER_TILE * 0.8
+        local x = k * layer.slot + (layer.slot - w) / 2 - ox
+        if top < oy + LAYER_TILE then
+            love.graphics.rectangle("fill", x, math.max(0, top - oy), w, LAYER_TILE)
+        end
+    end
+    love.graphics.pop()
+    return canvas
+end
+
+local function drawBackgroundLayers()
+    local screenW, screenH = camera.viewW, camera.viewH
+    for n = 1, layerCount do
+        local layer = backgroundLayers[n]
+        local ox = math.floor(camera.x * layer.parallax + 0.5)
+        local oy = math.floor(camera.y * layer.parallax + 0.5)
+        local ix1, iy1 = math.floor(ox / LAYER_TILE), math.floor(oy / LAYER_TILE)
+        local ix2 = math.floor((ox + screenW) / LAYER_TILE)
+        local iy2 = math.floor((oy + screenH) / LAYER_TILE)
+
+        local tiles = layer.tiles
+        for iy = iy1, iy2 do
+            for ix = ix1, ix2 do
+                local key = iy * 65536 + ix
+                local tile = tiles[key]
+                if not tile then
+                    tile = { canvas = bakeLayerTile(layer, ix, iy), ix = ix, iy = iy }
+                    tiles[key] = tile
+                end
+                love.graphics.draw(tile.canvas, ix * LAYER_TILE - ox, iy * LAYER_TILE - oy)
+            end
+        end
+
+        -- Keep one tile of slack around the view
+        for key, tile in pairs(tiles) do
+            if tile.ix < ix1 - 1 or tile.ix > ix2 + 1 or tile.iy < iy1 - 1 or tile.iy > iy2 + 1 then
+                tile.canvas:release()
+                tiles[key] = nil
             end
         end
     end
+end
+
+-- ======================
+-- WORLD GENERATION
+-- ======================
+-- Without a baked level, a pool of love.thread workers generates the
+-- world chunk by chunk, nearest the spawn point first. Chunks come back
+-- as ByteData, which threads share instead of copying, and are kept in
+-- world.generated so streaming can install them. The game only waits
+-- for the chunks around the spawn point; once every chunk is in, the
+-- level is written out and the streaming worker takes over.
+local GEN_MAX_WORKERS = 4
+
+local gen = {
+    active = false,
+    workers = {},
+    requests = nil,
+    results = nil,
+    remaining = 0 -- chunks not yet received
+}
+
+local function startGeneration()
+    gen.active = true
+    gen.requests = love.thread.newChannel()
+    gen.results = love.thread.newChannel()
+
+    local scx, scy = chunkOfTile(math.floor(player.x / TILE) + 1, math.floor(player.y / TILE) + 1)
+    local order, rings = {}, {}
+    for index = 1, world.chunkCols * world.chunkRows do
+        local cx, cy = chunkCoords(index)
+        order[index] = index
+        rings[index] = math.max(math.abs(cx - scx), math.abs(cy - scy))
+    end
+    table.sort(order, function(a, b)
+        if rings[a] ~= rings[b] then return rings[a] < rings[b] end
+        return a < b
+    end)
+    for _, index in ipairs(order) do
+        gen.requests:push(index)
+    end
+    gen.remaining = #order
+
+    -- Leave a core for the main thread
+    local count = math.max(1, math.min(GEN_MAX_WORKERS, love.system.getProcessorCount() - 1))
+    for i = 1, count do
+        gen.workers[i] = love.thread.newThread("genworker.lua")
+        gen.workers[i]:start(CHUNK, world.chunkCols, gen.requests, gen.results)
+        -- Queued behind the chunks, so each worker stops once they run out
+        gen.requests:push("quit")
+    end
+end
 
-    love.graphics.rectangle("fill", player.x, player.y, player.w, player.h)
+local function receiveGenerated(msg)
+    world.generated[msg.index] = msg.data
+    gen.remaining = gen.remaining - 1
+end
+
+-- Blocks until chunk `index` has been generated and returns its data
+local function awaitGenerated(index)
+    while not world.generated[index] do
+        receiveGenerated(gen.results:demand())
+    end
+    return world.generated[index]
+end
 
+-- Blocks until every chunk is in, then bakes the level file and drops
+-- the generated chunks
+local function finishGeneration()
+    while gen.remaining > 0 do
+        receiveGenerated(gen.results:demand())
+    end
+    for _, thread in ipairs(gen.workers) do
+        thread:wait()
+    end
+
+    local chunks = {}
+    for index, data in pairs(world.generated) do
+        chunks[index] = data:getString()
+    end
+    local byte = string.byte
+    assert(Level.write(LEVEL_PATH, world.width, world.height, CHUNK, function(tx, ty)
+        local cx, cy = chunkOfTile(tx, ty)
+        local lx, ly = tx - (cx - 1) * CHUNK, ty - (cy - 1) * CHUNK
+        return byte(chunks[chunkIndex(cx, cy)], (ly - 1) * CHUNK + lx)
+    end))
+    levelHeader = assert(Level.readHeader(LEVEL_PATH))
+    levelBaked = true
+
+    for index, data in pairs(world.generated) do
+        data:release()
+        world.generated[index] = nil
+    end
+    gen.workers = {}
+    gen.active = false
+end
+
+-- Collects finished chunks. Returns true on the call that bakes the
+-- level, so the caller can switch over to streaming from the file.
+local function updateGeneration()
+    local msg = gen.results:pop()
+    while msg do
+        receiveGenerated(msg)
+        msg = gen.results:pop()
+    end
+    if gen.remaining == 0 then
+        finishGeneration()
+        return true
+    end
+    return false
+end
+
+-- Stops the workers without waiting for the rest of the world
+local function stopGeneration()
+    if not gen.active then return end
+    gen.requests:clear()
+    for _ = 1, #gen.workers do
+        gen.requests:push("quit")
+    end
+    for _, thread in ipairs(gen.workers) do
+        thread:wait()
+    end
+    gen.workers = {}
+    gen.active = false
+end
+
+-- ======================
+-- WORLD STREAMING
+-- ======================
+-- A love.thread worker reads chunks from the level file. Two sets are
+-- kept resident: the chunks around the camera, and the chunks of the
+-- player's room and of every room one portal away (see rooms.lua), so
+-- the next room is already loaded when the player walks into it.
+-- Everything else is dropped again, so memory depends on the view and
+-- the size of rooms rather than on the size of the map.
+local roomGraph = Rooms.new(WorldGen.ROOMS, WorldGen.PORTALS, CHUNK, world.chunkCols)
+
+local stream = {
+    thread = nil,
+    requests = nil,
+    results = nil,
+    pending = {}, -- [chunkIndex] = true while a read is in flight
+    room = nil, -- room roomChunks was built for
+    roomChunks = {} -- [chunkIndex] = true for the room and its neighbours
+}
+
+local function loadChunk(index, data)
+    installChunk(index, data)
+    markChunkDirty(index)
+end
+
+local function unloadChunk(index)
+    removeChunkTiles(index)
+    local chunk = render.chunks[index]
+    if chunk then
+        chunk.batch:release()
+        render.chunks[index] = nil
+    end
+end
+
+-- Blocking read (or generation) of the chunks around the view that are
+-- not loaded yet, so the next frame already has ground under the player
+-- (at startup, and after a quickload moves them)
+local function preloadChunks()
+    local file = levelBaked and love.filesystem.newFile(LEVEL_PATH, "r")
+    local cx1, cy1, cx2, cy2 = viewChunkRange(STREAM_RADIUS * CHUNK)
+    for cy = cy1, cy2 do
+        for cx = cx1, cx2 do
+            local index = chunkIndex(cx, cy)
+            if not world.resident[index] then
+                if file then
+                    loadChunk(index, Level.readChunk(file, levelHeader, cx, cy))
+                else
+                    loadChunk(index, awaitGenerated(index))
+                end
+            end
+        end
+    end
+    if file then file:close() end
+end
+
+local function startStreaming()
+    stream.requests = love.thread.newChannel()
+    stream.results = love.thread.newChannel()
+    stream.thread = love.thread.newThread("streamworker.lua")
+    stream.thread:start(LEVEL_PATH, stream.requests, stream.results)
+end
+
+local function stopStreaming()
+    if stream.thread then
+        stream.requests:push("quit")
+        stream.thread:wait()
+        stream.thread = nil
+    end
+end
+
+-- Rebuilds roomChunks when the player has moved into another room
+local function updateRoomChunks()
+    local room = roomGraph:track(math.floor((player.x + player.w / 2) / TILE) + 1,
+        math.floor((player.y + player.h / 2) / TILE) + 1)
+    if room == stream.room then return end
+    stream.room = room
+
+    local set = stream.roomChunks
+    for index in pairs(set) do
+        set[index] = nil
+    end
+    if not room then return end
+    for _, index in ipairs(room.chunks) do
+        set[index] = true
+    end
+    for _, neighbour in ipairs(room.neighbours) do
+        for _, index in ipairs(neighbour.chunks) do
+            set[index] = true
+        end
+    end
+end
+
+-- While generating, chunks are installed as soon as they arrive
+local function requestChunk(index)
+    if world.resident[index] then return end
+    local data = world.generated[index]
+    if data then
+        loadChunk(index, data)
+    elseif stream.thread and not stream.pending[index] then
+        stream.pending[index] = true
+        stream.requests:push(index)
+    end
+end
+
+local function updateStreaming()
+    if gen.active and updateGeneration() then
+        startStreaming()
+    end
+    updateRoomChunks()
+
+    if stream.thread then
+        local msg = stream.results:pop()
+        while msg do
+            stream.pending[msg.index] = nil
+            if not world.resident[msg.index] then
+                loadChunk(msg.index, msg.data)
+            end
+            msg = stream.results:pop()
+        end
+    end
+
+    -- The view first, so the requests that matter now go out first
+    local cx1, cy1, cx2, cy2 = viewChunkRange(STREAM_RADIUS * CHUNK)
+    for cy = cy1, cy2 do
+        for cx = cx1, cx2 do
+            requestChunk(chunkIndex(cx, cy))
+        end
+    end
+    for index in pairs(stream.roomChunks) do
+        requestChunk(index)
+    end
+
+    -- Recordings keep the whole level (see loadAllChunks)
+    if sim.recording or sim.playback then return end
+
+    -- One extra chunk of slack so chunks on the edge do not thrash
+    local kx1, ky1, kx2, ky2 = viewChunkRange((STREAM_RADIUS + 1) * CHUNK)
+    for index in pairs(world.resident) do
+        local cx, cy = chunkCoords(index)
+        if not stream.roomChunks[index] and (cx < kx1 or cx > kx2 or cy < ky1 or cy > ky2) then
+            unloadChunk(index)
+        end
+    end
+end
+
+-- Blocking load of every chunk, finishing generation first if needed.
+-- Entity activity and collision both depend on what is loaded, which
+-- otherwise depends on streaming timing, so recording and playback
+-- run with the whole level resident.
+local function loadAllChunks()
+    if gen.active then
+        finishGeneration()
+        startStreaming()
+    end
+    local file
+    for index = 1, world.chunkCols * world.chunkRows do
+        if not world.resident[index] then
+            file = file or love.filesystem.newFile(LEVEL_PATH, "r")
+            loadChunk(index, Level.readChunk(file, levelHeader, chunkCoords(index)))
+        end
+    end
+    if file then file:close() end
+end
+
+-- ======================
+-- FRAME
+-- ======================
+-- Puts the simulation back in its starting state, so a recording made
+-- from here can be replayed exactly
+local function resetGame(seed)
+    for k, v in pairs(playerStart) do
+        player[k] = v
+    end
+    clearEntities()
+    spawnWorldEntities()
+    clearParticles()
+    revertTileEdits()
+    resetInput()
+    sim.tick = 0
+    sim.seed = seed
+    love.math.setRandomSeed(seed)
+end
+
+-- Applies this tick's input: the recording being played back, or the
+-- queued keyboard/script events (recorded if a recording is running)
+local function feedInput(tick)
+    if sim.playback then
+        inputQueue.count = 0
+        if not Replay.playStep(sim.playback, tick, applyAction) then
+            sim.playback = nil
+            print("replay finished at tick " .. tick)
+        end
+        return
+    end
+
+    for i = 1, inputQueue.count do
+        local action, down = inputQueue.actions[i], inputQueue.downs[i]
+        applyAction(action, down)
+        if sim.recording then
+            Replay.record(sim.recording, tick, action, down)
+        end
+    end
+    inputQueue.count = 0
+end
+
+local function stepSimulation()
+    sim.tick = sim.tick + 1
+    feedInput(sim.tick)
+
+    player.prevX, player.prevY = player.x, player.y
+
+    Profiler.start("sim.player")
+    updatePlayer(player, FIXED_DT)
+    Profiler.stop("sim.player")
+
+    Profiler.start("sim.entities")
+    updateEntities(FIXED_DT)
+    Profiler.stop("sim.entities")
+
+    Profiler.start("sim.particles")
+    updateParticles(FIXED_DT)
+    Profiler.stop("sim.particles")
+end
+
+-- `zoom` is target pixels per world pixel
+local function drawWorld(zoom)
+    love.graphics.push()
+    love.graphics.scale(zoom)
+
+    Profiler.start("draw.background")
+    drawBackgroundLayers()
+    Profiler.stop("draw.background")
+
+    love.graphics.push()
+    camera:apply(zoom)
+
+    Profiler.start("draw.tiles")
+    drawTiles()
+    Profiler.stop("draw.tiles")
+
+    Profiler.start("draw.entities")
+    drawEntities()
+    drawParticles()
+
+    local px, py = renderPos(player)
+    love.graphics.rectangle("fill", px, py, player.w, player.h)
+    Profiler.stop("draw.entities")
+
+    drawCollisionRects()
+
+    love.graphics.pop()
     love.graphics.pop()
 end
 
+-- ======================
+-- DISPLAY
+-- ======================
+-- The world is drawn straight to the window, or (F7) to a fixed
+-- LOW_RES_W x LOW_RES_H canvas that is scaled up by a whole factor with
+-- nearest filtering and letterboxed. The canvas shows the same area of
+-- the world as a 1280x720 window, so fill rate no longer grows with the
+-- window size.
+local LOW_RES_W, LOW_RES_H = 640, 360
+local LOW_RES_ZOOM = 0.5 -- canvas pixels per world pixel
+
+local display = {
+    lowRes = false,
+    canvas = nil,
+    scale = 1, -- window pixels per canvas pixel
+    offsetX = 0, offsetY = 0
+}
+
+-- Fits the view to a w x h window
+local function layoutDisplay(w, h)
+    if display.lowRes then
+        local scale = math.max(1, math.floor(math.min(w / LOW_RES_W, h / LOW_RES_H)))
+        display.scale = scale
+        display.offsetX = math.floor((w - LOW_RES_W * scale) / 2)
+        display.offsetY = math.floor((h - LOW_RES_H * scale) / 2)
+        camera:resize(LOW_RES_W / LOW_RES_ZOOM, LOW_RES_H / LOW_RES_ZOOM)
+    else
+        camera:resize(w, h)
+    end
+end
+
+local function setLowRes(enabled)
+    display.lowRes = enabled
+    if enabled and not display.canvas then
+        display.canvas = love.graphics.newCanvas(LOW_RES_W, LOW_RES_H)
+        display.canvas:setFilter("nearest", "nearest")
+    end
+    layoutDisplay(love.graphics.getDimensions())
+end
+
+-- Thin bar along the bottom of the window while assets are loading
+local function drawLoadingBar()
+    if not Assets.isLoading() then return end
+    local done, total = Assets.progress()
+    local w, h = love.graphics.getDimensions()
+    love.graphics.setColor(1, 1, 1, 0.25)
+    love.graphics.rectangle("fill", 0, h - 4, w, 4)
+    love.graphics.setColor(1, 1, 1, 0.9)
+    love.graphics.rectangle("fill", 0, h - 4, w * done / total, 4)
+    love.graphics.setColor(1, 1, 1)
+end
+
+-- ======================
+-- QUALITY
+-- ======================
+-- The adaptive scaler (quality.lua) moves between these levels to hold
+-- 60 fps. F7 (manual low resolution) turns it off; F10 toggles it.
+local QUALITY_LEVELS = {
+    { lowRes = false, particles = PARTICLE_CAPACITY, layers = 2, activity = 1 },
+    { lowRes = false, particles = 256, layers = 1, activity = 0.75 },
+    { lowRes = true, particles = 128, layers = 1, activity = 0.5 },
+    { lowRes = true, particles = 64, layers = 0, activity = 0.35 }
+}
+
+local quality = nil -- created in love.load, once there is a window
+
+-- Current level and scaler state, on the profiler overlay (F3)
+local function showQualityStatus(index, enabled)
+    Profiler.setStatus("quality", string.format("quality %d/%d   adaptive %s",
+        index, #QUALITY_LEVELS, enabled and "on" or "off"))
+end
+
+local function applyQuality(level, index)
+    if level.lowRes ~= display.lowRes then
+        setLowRes(level.lowRes)
+    end
+    particles.limit = level.particles
+    setLayerCount(level.layers)
+    activity.scale = level.activity
+    -- Also called from Quality.new, before `quality` is set
+    showQualityStatus(index, not quality or quality.enabled)
+end
+
+local function updateQuality(dt)
+    if not quality then return end
+    -- Half a second of frames, well inside the profiler's window
+    quality:update(dt, Profiler.recentAverage("frame", 30), Profiler.recentAverage("cpu", 30))
+end
+
+local function drawDisplay()
+    if not display.lowRes then
+        drawWorld(1)
+        return
+    end
+    love.graphics.setCanvas(display.canvas)
+    love.graphics.clear(love.graphics.getBackgroundColor())
+    drawWorld(LOW_RES_ZOOM)
+    love.graphics.setCanvas()
+    love.graphics.draw(display.canvas, display.offsetX, display.offsetY, 0, display.scale)
+end
+
+-- ======================
+-- RECORDING
+-- ======================
+local REPLAY_PATH = "replays/last.ggin"
+
+-- F5 restarts the game and records until pressed again
+local function toggleRecording()
+    if sim.recording then
+        sim.recording.length = sim.tick
+        assert(Replay.save(REPLAY_PATH, sim.recording))
+        print(string.format("recorded %d ticks to %s/%s", sim.tick,
+            love.filesystem.getSaveDirectory(), REPLAY_PATH))
+        sim.recording = nil
+    else
+        sim.playback = nil
+        local seed = os.time()
+        loadAllChunks()
+        resetGame(seed)
+        sim.recording = Replay.new(seed)
+    end
+end
+
+-- F6 restarts the game and plays the last recording back
+local function playLastRecording()
+    if sim.recording or not love.filesystem.getInfo(REPLAY_PATH) then return end
+    local rec = assert(Replay.load(REPLAY_PATH))
+    loadAllChunks()
+    resetGame(rec.seed)
+    sim.playback = Replay.newPlayback(rec)
+end
+
+-- ======================
+-- SNAPSHOTS
+-- ======================
+-- A snapshot is the simulation's runtime state: tick, random state,
+-- input, player, every entity and the tile edits made on top of the
+-- level (the level itself is not stored). Particles are cosmetic and
+-- are simply cleared on restore.
+--
+-- In memory a snapshot is a buffer: the values in one flat numeric
+-- array (newArray, so a C array of doubles on the FFI path) plus the
+-- random state string. Buffers are written in place and only grow when
+-- the state outgrows them, so the rewind ring takes one every step
+-- without building new objects; the random state string is the only
+-- allocation. Restoring applies the edits as a diff against the
+-- current ones. Quicksaves encode a buffer to this file format:
+--
+--   "GGSS"  magic
+--   u16     version
+--   u32     tick
+--   u32     seed
+--   s2      love.math random state
+--   u8      input flags, bit n-1 for INPUT_FLAGS[n]
+--   player  PLAYER_STATE as doubles (booleans as 0/1)
+--   u32     entity count, then ENTITY_FORMAT per entity
+--   u32     edit count, then (u32 tile index, u8 id) per edit
+--
+-- The buffer holds the same values in the same order, all as numbers.
+local SNAPSHOT_MAGIC = "GGSS"
+local SNAPSHOT_VERSION = 1
+local SNAPSHOT_HEADER = "<I2I4I4s2B"
+local SNAPSHOT_PATH = "saves/quick.ggss"
+
+local INPUT_FLAGS = { "left", "right", "jumpPressed", "jumpHeld", "dashPressed", "firePressed" }
+local PLAYER_FORMAT = "<" .. string.rep("d", #PLAYER_STATE)
+
+local ENTITY_CODES = { uint8_t = "B", double = "d", bool = "B" }
+local ENTITY_FORMAT = "<"
+for _, field in ipairs(ENTITY_FIELDS) do
+    ENTITY_FORMAT = ENTITY_FORMAT .. ENTITY_CODES[field[2]]
+end
+
+-- Tick, seed, flags, the player, and the entity and edit counts
+local SNAPSHOT_FIXED = 3 + #PLAYER_STATE + 2
+
+local function newSnapshotBuffer(capacity)
+    return { values = newArray("double", capacity), capacity = capacity, size = 0, randomState = nil }
+end
+
+-- Writes the current state into `buf`, or into a new buffer when `buf`
+-- is nil or too small, and returns the buffer written
+local function takeSnapshot(buf)
+    local e = entities
+    local edits = 0
+    for _, chunkEdits in pairs(world.edits) do
+        for _ in pairs(chunkEdits) do
+            edits = edits + 1
+        end
+    end
+    local size = SNAPSHOT_FIXED + e.count * #ENTITY_FIELDS + edits * 2
+    if not buf or buf.capacity < size then
+        buf = newSnapshotBuffer(math.max(size, buf and buf.capacity * 2 or 0))
+    end
+    local v = buf.values
+
+    local flags = 0
+    for b, name in ipairs(INPUT_FLAGS) do
+        if input[name] then flags = bor(flags, lshift(1, b - 1)) end
+    end
+    v[1], v[2], v[3] = sim.tick, sim.seed, flags
+    local n = 3
+
+    for _, name in ipairs(PLAYER_STATE) do
+        local value = player[name]
+        if type(value) == "boolean" then value = value and 1 or 0 end
+        n = n + 1
+        v[n] = value
+    end
+
+    n = n + 1
+    v[n] = e.count
+    for i = 1, e.count do
+        for _, field in ipairs(ENTITY_FIELDS) do
+            local value = e[field[1]][i]
+            if field[2] == "bool" then value = value and 1 or 0 end
+            n = n + 1
+            v[n] = value
+        end
+    end
+
+    n = n + 1
+    v[n] = edits
+    for _, chunkEdits in pairs(world.edits) do
+        for i, id in pairs(chunkEdits) do
+            v[n + 1], v[n + 2] = i, id
+            n = n + 2
+        end
+    end
+
+    buf.size = n
+    buf.randomState = love.math.getRandomState()
+    return buf
+end
+
+-- Reused while restoring: [tileIndex] = id of the snapshot's edits
+local snapshotEdits = {}
+
+-- Puts the simulation back in the state `buf` was taken in
+local function restoreSnapshot(buf)
+    local v = buf.values
+    sim.tick, sim.seed = v[1], v[2]
+    love.math.setRandomState(buf.randomState)
+    -- Saved input only stands while a recording drives it
+    if sim.playback then
+        resetInput()
+        for b, name in ipairs(INPUT_FLAGS) do
+            input[name] = band(v[3], lshift(1, b - 1)) ~= 0
+        end
+    else
+        readHeldInput()
+    end
+    local n = 3
+
+    for _, name in ipairs(PLAYER_STATE) do
+        n = n + 1
+        local value = v[n]
+        if type(playerStart[name]) == "boolean" then value = value ~= 0 end
+        player[name] = value
+    end
+
+    clearEntities()
+    local e = entities
+    n = n + 1
+    for i = 1, v[n] do
+        for _, field in ipairs(ENTITY_FIELDS) do
+            n = n + 1
+            local value = v[n]
+            if field[2] == "bool" then value = value ~= 0 end
+            e[field[1]][i] = value
+        end
+        e.count = i
+        e.grid:insert(i, e.x[i], e.y[i], e.w[i], e.h[i])
+    end
+
+    -- Edits on chunks that are not loaded are kept for when they are
+    n = n + 1
+    local target = snapshotEdits
+    for _ = 1, v[n] do
+        target[v[n + 1]] = v[n + 2]
+        n = n + 2
+    end
+    applyTileEdits(target)
+
+    clearParticles()
+end
+
+local snapshotRow = {} -- reused by readRow
+
+-- Returns the `count` buffer values after `pos`
+local function readRow(v, pos, count)
+    for k = 1, count do
+        snapshotRow[k] = v[pos + k]
+    end
+    return unpack(snapshotRow, 1, count)
+end
+
+local function encodeSnapshot(buf)
+    local pack, v = love.data.pack, buf.values
+    local parts = {
+        SNAPSHOT_MAGIC,
+        pack("string", SNAPSHOT_HEADER, SNAPSHOT_VERSION, v[1], v[2], buf.randomState, v[3]),
+        pack("string", PLAYER_FORMAT, readRow(v, 3, #PLAYER_STATE))
+    }
+    local n = 3 + #PLAYER_STATE + 1
+    parts[#parts + 1] = pack("string", "<I4", v[n])
+    for _ = 1, v[n] do
+        parts[#parts + 1] = pack("string", ENTITY_FORMAT, readRow(v, n, #ENTITY_FIELDS))
+        n = n + #ENTITY_FIELDS
+    end
+    n = n + 1
+    parts[#parts + 1] = pack("string", "<I4", v[n])
+    for _ = 1, v[n] do
+        parts[#parts + 1] = pack("string", "<I4B", v[n + 1], v[n + 2])
+        n = n + 2
+    end
+    return table.concat(parts)
+end
+
+-- Reads a snapshot file into a new buffer. Returns nil and a message
+-- if the data is not a snapshot we can read: every length is checked
+-- before it is unpacked, and counts and tile indices are checked
+-- against the fixed-size stores they are restored into.
+local function decodeSnapshot(data)
+    if #data < 4 or data:sub(1, 4) ~= SNAPSHOT_MAGIC then
+        return nil, "not a snapshot"
+    end
+    local unpackData, packedSize = love.data.unpack, love.data.getPackedSize
+    local pos = 5
+    local function has(bytes)
+        return #data - pos + 1 >= bytes
+    end
+
+    -- SNAPSHOT_HEADER, with the s2 string's length read first
+    if not has(packedSize("<I2I4I4I2")) then return nil, "truncated snapshot" end
+    local version, tick, seed, stateLen
+    version, tick, seed, stateLen, pos = unpackData("<I2I4I4I2", data, pos)
+    if version ~= SNAPSHOT_VERSION then
+        return nil, "unsupported snapshot version " .. version
+    end
+    if not has(stateLen + 1) then return nil, "truncated snapshot" end
+    local randomState = data:sub(pos, pos + stateLen - 1)
+    local flags = data:byte(pos + stateLen)
+    pos = pos + stateLen + 1
+    if not randomState:match("^0x%x+$") then return nil, "bad random state in snapshot" end
+
+    local values = { tick, seed, flags }
+    -- Appends one unpacked row; unpack returns the next position last
+    local function append(format)
+        local row = { unpackData(format, data, pos) }
+        for k = 1, #row - 1 do
+            values[#values + 1] = row[k]
+        end
+        pos = row[#row]
+    end
+
+    if not has(packedSize(PLAYER_FORMAT) + 4) then return nil, "truncated snapshot" end
+    append(PLAYER_FORMAT)
+    local count
+    count, pos = unpackData("<I4", data, pos)
+    if count > ENTITY_CAPACITY then
+        return nil, "snapshot has " .. count .. " entities, more than " .. ENTITY_CAPACITY
+    end
+    if not has(count * packedSize(ENTITY_FORMAT) + 4) then return nil, "truncated snapshot" end
+    values[#values + 1] = count
+    for _ = 1, count do
+        append(ENTITY_FORMAT)
+    end
+
+    count, pos = unpackData("<I4", data, pos)
+    local editSize = packedSize("<I4B")
+    if #data - pos + 1 ~= count * editSize then return nil, "snapshot length does not match its edits" end
+    values[#values + 1] = count
+    local tileCount = world.width * world.height
+    for _ = 1, count do
+        append("<I4B")
+        if values[#values - 1] < 1 or values[#values - 1] > tileCount then
+            return nil, "snapshot edit outside the world"
+        end
+    end
+
+    local buf = newSnapshotBuffer(#values)
+    for k = 1, #values do
+        buf.values[k] = values[k]
+    end
+    buf.size = #values
+    buf.randomState = randomState
+    return buf
+end
+
+-- F8 / F9 quicksave and quickload
+local function quickSave()
+    love.filesystem.createDirectory("saves")
+    assert(love.filesystem.write(SNAPSHOT_PATH, encodeSnapshot(takeSnapshot())))
+    print("saved to " .. love.filesystem.getSaveDirectory() .. "/" .. SNAPSHOT_PATH)
+end
+
+local function quickLoad()
+    if sim.recording or sim.playback then return end
+    local data = love.filesystem.read(SNAPSHOT_PATH)
+    if not data then return end
+    local buf, err = decodeSnapshot(data)
+    if not buf then
+        Profiler.setStatus("save", "quickload failed: " .. err)
+        return
+    end
+    Profiler.setStatus("save", nil)
+    restoreSnapshot(buf)
+    -- Collision treats missing chunks as empty, so load the player's
+    -- surroundings before the next step
+    snapCamera()
+    preloadChunks()
+end
+
+-- Holding backspace steps back through a ring of the last
+-- REWIND_STEPS snapshots, one per simulation step. Slots keep their
+-- buffers once filled, so the ring is written in place.
+local REWIND_STEPS = 600
+
+local rewind = {
+    buffer = {},
+    head = 0, -- slot of the newest snapshot
+    count = 0
+}
+
+local function pushRewind()
+    rewind.head = rewind.head % REWIND_STEPS + 1
+    rewind.buffer[rewind.head] = takeSnapshot(rewind.buffer[rewind.head])
+    rewind.count = math.min(rewind.count + 1, REWIND_STEPS)
+end
+
+local function isRewinding()
+    return love.keyboard.isDown("backspace") and not (sim.recording or sim.playback)
+end
+
+-- Drops the newest snapshot and restores the one before it
+local function stepRewind()
+    if rewind.count < 2 then return end
+    rewind.head = (rewind.head - 2) % REWIND_STEPS + 1
+    rewind.count = rewind.count - 1
+    restoreSnapshot(rewind.buffer[rewind.head])
+end
+
+-- ======================
+-- BENCHMARK
+-- ======================
+-- `love . --bench`: loads the whole level, drives `input` from a
+-- recorded script for a fixed number of simulation steps and reports
+-- steps per second. With `--render`, also times full frames while the
+-- camera pans across the world.
+local function runBenchmark(opts)
+    Profiler.setEnabled(false)
+
+    if not levelBaked then
+        startGeneration()
+        finishGeneration()
+    end
+    assert(Level.load(LEVEL_PATH, world.tiles))
+    for index = 1, world.chunkCols * world.chunkRows do
+        world.resident[index] = true
+        rebuildSolidChunk(index)
+    end
+    refreshMasks(1, 1, world.width, world.height)
+
+    -- A recorded session replaces the input script and its seed
+    local script, steps
+    if opts.replay then
+        local rec = assert(Replay.load(opts.replay))
+        resetGame(rec.seed)
+        sim.playback = Replay.newPlayback(rec)
+        steps = rec.length
+    else
+        resetGame(opts.seed)
+        script = Bench.newReplay(Bench.loadScript(opts.script))
+        steps = opts.steps
+    end
+
+    local trace = opts.trace and { "tick,x,y,vx,vy" }
+    local getTime = love.timer.getTime
+
+    print("storage: " .. (ffi and "ffi" or "lua"))
+    local t0 = getTime()
+    for tick = 1, steps do
+        if script then
+            Bench.replayStep(script, tick, handleKey)
+        end
+        stepSimulation()
+        if trace then
+            trace[#trace + 1] = string.format("%d,%.17g,%.17g,%.17g,%.17g",
+                tick, player.x, player.y, player.vx, player.vy)
+        end
+    end
+    local elapsed = getTime() - t0
+    opts.steps = steps
+
+    if trace then
+        love.filesystem.write(opts.trace, table.concat(trace, "\n") .. "\n")
+        print("trace written to " .. love.filesystem.getSaveDirectory() .. "/" .. opts.trace)
+    end
+
+    print(string.format("sim: %d steps in %.3f s, %.0f steps/s, %.4f ms/step",
+        opts.steps, elapsed, opts.steps / elapsed, elapsed / opts.steps * 1000))
+    print(string.format("sim: player at %.3f, %.3f, %d entities, %d particles",
+        player.x, player.y, entities.count, particles.count))
+
+    if opts.render and love.graphics then
+        love.window.setMode(1280, 720, { vsync = 0 })
+        Assets.start()
+        initTileRenderer()
+        Assets.finish()
+        updateTileRenderer()
+
+        camera:resize(love.graphics.getDimensions())
+        local spanX = math.max(0, world.width * TILE - camera.viewW)
+        local bottomY = world.height * TILE - camera.viewH
+
+        t0 = getTime()
+        for frame = 1, opts.frames do
+            camera:setPosition(spanX * (frame - 1) / math.max(1, opts.frames - 1), bottomY)
+            love.graphics.origin()
+            love.graphics.clear(love.graphics.getBackgroundColor())
+            drawWorld(1)
+            love.graphics.present()
+        end
+        elapsed = getTime() - t0
+
+        print(string.format("render: %d frames in %.3f s, %.0f fps, %.3f ms/frame",
+            opts.frames, elapsed, opts.frames / elapsed, elapsed / opts.frames * 1000))
+    end
+end
+
+-- ======================
+-- LOVE
+-- ======================
+local frameStart = 0 -- love.timer time at the top of the current frame
+
+function love.load(args)
+    if Bench.isRequested(args) then
+        runBenchmark(Bench.parseArgs(args))
+        love.event.quit()
+        return
+    end
+
+    love.window.setMode(1280, 720, { resizable = true })
+    Assets.start()
+    initTileRenderer()
+
+    layoutDisplay(love.graphics.getDimensions())
+    snapCamera()
+
+    Memory.init()
+    Profiler.setHeapBudget(Memory.LIMIT_KB)
+    quality = Quality.new(QUALITY_LEVELS, 1000 / 60, applyQuality)
+    if levelBaked then
+        preloadChunks()
+        startStreaming()
+    else
+        startGeneration()
+        preloadChunks()
+    end
+end
+
+function love.update(dt)
+    frameStart = love.timer.getTime()
+    Profiler.beginFrame()
+    Memory.update(frameStart)
+    sim.accumulator = sim.accumulator + dt
+
+    local steps = 0
+    while sim.accumulator >= FIXED_DT and steps < MAX_STEPS do
+        if isRewinding() then
+            stepRewind()
+        else
+            stepSimulation()
+            pushRewind()
+        end
+        sim.accumulator = sim.accumulator - FIXED_DT
+        steps = steps + 1
+    end
+
+    -- After a long hitch, drop the backlog instead of spiralling
+    if steps == MAX_STEPS then
+        sim.accumulator = math.min(sim.accumulator, FIXED_DT)
+    end
+    sim.alpha = sim.accumulator / FIXED_DT
+
+    Profiler.start("camera")
+    updateCamera(dt)
+    Profiler.stop("camera")
+
+    updateQuality(dt)
+
+    Profiler.start("assets")
+    Assets.update(ASSET_BUDGET_MS)
+    updateTileRenderer()
+    Profiler.stop("assets")
+
+    Profiler.start("streaming")
+    updateStreaming()
+    Profiler.stop("streaming")
+end
+
+function love.resize(w, h)
+    layoutDisplay(w, h)
+end
+
+function love.quit()
+    Assets.stop()
+    stopGeneration()
+    stopStreaming()
+end
+
+function love.draw()
+    drawDisplay()
+    drawLoadingBar()
+
+    -- Collect in what is left of the frame
+    Profiler.start("gc")
+    Memory.step(frameStart)
+    Profiler.stop("gc")
+    if Profiler.isVisible() then
+        local stepMs, cycles, forced = Memory.getStats()
+        Profiler.setStatus("gc", string.format("gc step %.2f / %.1f ms   cycles %d   forced %d",
+            stepMs, Memory.BUDGET_MS, cycles, forced))
+        Profiler.setStatus("entities", string.format("entities %d / %d   dropped %d",
+            entities.count, ENTITY_CAPACITY, entities.dropped))
+        Profiler.setStatus("particles", string.format("particles %d / %d   dropped %d",
+            particles.count, particles.limit, particles.dropped))
+    end
+
+    Profiler.endFrame()
+    Profiler.drawOverlay()
+end
+
 function love.keypressed(k)
-    if k == "a" then input.left = true end
-    if k == "d" then input.right = true end
-    if k == "space" then
-        input.jumpPressed = true
-        input.jumpHeld = true
+    handleKey(k, true)
+    if k == "f2" then showCollisionRects = not showCollisionRects end
+    if k == "f3" then Profiler.toggleOverlay() end
+    if k == "f5" then toggleRecording() end
+    if k == "f6" then playLastRecording() end
+    if k == "f7" then
+        quality.enabled = false
+        setLowRes(not display.lowRes)
+        showQualityStatus(quality.index, quality.enabled)
+    end
+    if k == "f10" then
+        quality.enabled = not quality.enabled
+        showQualityStatus(quality.index, quality.enabled)
+    end
+    if k == "f8" then quickSave() end
+    if k == "f9" then quickLoad() end
+    if k == "f4" then
+        local path = os.date("profile-%Y%m%d-%H%M%S.csv")
+        if Profiler.dumpCSV(path) then
+            print("profile written to " .. love.filesystem.getSaveDirectory() .. "/" .. path)
+        end
     end
-    if k == "lshift" then input.dashPressed = true end
 end
 
 function love.keyreleased(k)
-    if k == "a" then input.left = false end
-    if k == "d" then input.right = false end
-    if k == "space" then input.jumpHeld = false end
+    handleKey(k, false)
 end
-
@@ -0,0 +1,105 @@
+-- =========================================================
+-- GARBAGE COLLECTOR CONTROL
+-- =========================================================
+-- Replaces LuaJIT's automatic collector with incremental steps taken
+-- by hand, once per frame, in whatever time is left of the frame and
+-- never more than BUDGET_MS. A write-heavy moment (a dash full of
+-- particles) then costs a little every frame instead of one long
+-- collection in the middle of it.
+--
+--   Memory.init()
+--   ...
+--   Memory.update(frameStart) -- once per update
+--   Memory.step(frameStart)   -- once per frame, after drawing
+--
+-- love.run skips drawing while the window is minimised; update() then
+-- takes the step instead, so the heap is still collected and capped.
+--
+-- Like the automatic collector, a new cycle only starts once the heap
+-- has grown by PAUSE since the last one finished. If the heap goes
+-- over LIMIT_KB anyway, a full collection is forced and counted.
+--
+-- Finishing a cycle (by step or collect) re-arms the automatic
+-- collector, so it is stopped again after every call.
+
+require("love.timer")
+
+local Memory = {}
+
+Memory.BUDGET_MS = 1.0 -- most time spent collecting per frame
+Memory.MIN_MS = 0.1 -- least, even when the frame is already late
+Memory.FRAME_TIME = 1 / 60 -- frame the leftover time is measured against
+Memory.STEP_KB = 16 -- work per collectgarbage("step") call
+Memory.PAUSE = 2.0 -- heap growth that starts a new cycle
+Memory.LIMIT_KB = 64 * 1024
+
+local getTime = love.timer.getTime
+
+local state = {
+    active = false,
+    stepped = false, -- a step ran since the last update
+    collecting = false, -- a cycle is in progress
+    threshold = 0, -- heap size (KB) that starts the next cycle
+    lastStepMs = 0,
+    cycles = 0,
+    forced = 0
+}
+
+function Memory.init()
+    collectgarbage("collect")
+    collectgarbage("stop")
+    state.active = true
+    state.stepped = true
+    state.threshold = collectgarbage("count") * Memory.PAUSE
+end
+
+function Memory.step(frameStart)
+    if not state.active then return end
+    local now = getTime()
+    state.lastStepMs = 0
+    state.stepped = true
+
+    local heap = collectgarbage("count")
+    if heap > Memory.LIMIT_KB then
+        collectgarbage("collect")
+        collectgarbage("stop")
+        state.forced = state.forced + 1
+        state.collecting = false
+        state.threshold = collectgarbage("count") * Memory.PAUSE
+        state.lastStepMs = (getTime() - now) * 1000
+        return
+    end
+
+    if not state.collecting then
+        if heap < state.threshold then return end
+        state.collecting = true
+    end
+
+    local left = frameStart + Memory.FRAME_TIME - now
+    local stop = now + math.max(Memory.MIN_MS / 1000, math.min(left, Memory.BUDGET_MS / 1000))
+    repeat
+        if collectgarbage("step", Memory.STEP_KB) then
+            state.collecting = false
+            state.cycles = state.cycles + 1
+            state.threshold = collectgarbage("count") * Memory.PAUSE
+            break
+        end
+    until getTime() >= stop
+    collectgarbage("stop")
+    state.lastStepMs = (getTime() - now) * 1000
+end
+
+-- Steps here when the last frame was not drawn
+function Memory.update(frameStart)
+    if not state.stepped then
+        Memory.step(frameStart)
+    end
+    state.stepped = false
+end
+
+-- Time spent in the last step, completed cycles and forced collections
+function Memory.getStats()
+    return state.lastStepMs, state.cycles, state.forced
+end
+
+return Memory
@@ -0,0 +1,41 @@
+-- =========================================================
+-- OBJECT POOL
+-- =========================================================
+-- Fixed-capacity free list of reusable tables. Every object is created
+-- up front, so acquire/release never allocate; when the pool is empty
+-- acquire returns nil and the caller is expected to skip the spawn.
+
+local Pool = {}
+Pool.__index = Pool
+
+-- `create` builds one blank object
+function Pool.new(create, capacity)
+    local free = {}
+    for i = 1, capacity do
+        free[i] = create()
+    end
+    return setmetatable({
+        free = free,
+        freeCount = capacity,
+        capacity = capacity
+    }, Pool)
+end
+
+function Pool:acquire()
+    local n = self.freeCount
+    if n == 0 then
+        return nil
+    end
+    local obj = self.free[n]
+    self.free[n] = nil
+    self.freeCount = n - 1
+    return obj
+end
+
+function Pool:release(obj)
+    local n = self.freeCount + 1
+    self.free[n] = obj
+    self.freeCount = n
+end
+
+return Pool
@@ -0,0 +1,301 @@
+-- =========================================================
+-- FRAME PROFILER
+-- =========================================================
+-- Scoped timers around named phases, kept per frame in a ring of the
+-- last WINDOW frames. A phase may run several times in one frame (e.g.
+-- fixed simulation steps); its times are summed for that frame.
+--
+--   Profiler.beginFrame()          -- once, at the top of love.update
+--   Profiler.start("draw.tiles")
+--   ...
+--   Profiler.stop("draw.tiles")
+--   Profiler.endFrame()            -- once, at the end of love.draw
+--
+-- Each scope also records how much the Lua heap grew while it was open,
+-- which gives per-subsystem allocation rates. The figure is exact only
+-- while the automatic collector is stopped (see memory.lua); otherwise
+-- a collection inside the scope hides part of it.
+--
+-- The overlay shows rolling min/avg/p99 per phase, average KB allocated
+-- per frame, a frame-time graph, draw calls and the Lua heap against
+-- its budget, plus named status lines set by the game. dumpCSV writes
+-- the raw window.
+
+require("love.timer")
+
+local Profiler = {}
+
+local WINDOW = 240 -- frames kept
+local STATS_INTERVAL = 0.25 -- seconds between overlay stat refreshes
+local GRAPH_MS = 33.3 -- frame time at the top of the graph
+
+local getTime = love.timer.getTime
+
+local state = {
+    enabled = true,
+    visible = false,
+    frame = 0, -- frames recorded so far
+    slot = 1, -- ring slot of the current frame
+    frameStart = nil,
+    lastFrameStart = nil,
+
+    phases = {}, -- ordered phase names
+    samples = {}, -- [name] = ring of per-frame seconds
+    allocs = {}, -- [name] = ring of per-frame KB allocated
+    started = {}, -- [name] = start time of the open scope
+    heapStart = {}, -- [name] = heap KB when the open scope started
+
+    frameTimes = {}, -- ring of wall time between frames
+    cpuTimes = {}, -- ring of time spent inside beginFrame..endFrame
+
+    stats = {}, -- [name] = { min, avg, p99 } in ms, alloc in KB per frame
+    heapBudget = nil, -- KB, shown next to the heap size when set
+    statusKeys = {}, -- status line names, in the order first set
+    status = {}, -- [name] = text, see setStatus
+    statsAge = math.huge,
+    scratch = {},
+    graphics = {}, -- reused love.graphics.getStats table
+    drawCalls = 0,
+    textureMemory = 0
+}
+
+local function ring(t)
+    for i = 1, WINDOW do t[i] = 0 end
+    return t
+end
+ring(state.frameTimes)
+ring(state.cpuTimes)
+
+local function addPhase(name)
+    state.phases[#state.phases + 1] = name
+    state.samples[name] = ring({})
+    state.allocs[name] = ring({})
+    state.stats[name] = { min = 0, avg = 0, p99 = 0, alloc = 0 }
+end
+addPhase("frame")
+addPhase("cpu")
+state.samples.frame = state.frameTimes
+state.samples.cpu = state.cpuTimes
+
+function Profiler.setEnabled(enabled)
+    state.enabled = enabled
+end
+
+function Profiler.setHeapBudget(kb)
+    state.heapBudget = kb
+end
+
+-- Sets the overlay status line `name`; nil text hides it. Lines keep
+-- the order in which they were first set.
+function Profiler.setStatus(name, text)
+    if state.status[name] == nil and text ~= nil then
+        local known = false
+        for _, key in ipairs(state.statusKeys) do
+            if key == name then known = true end
+        end
+        if not known then
+            state.statusKeys[#state.statusKeys + 1] = name
+        end
+    end
+    state.status[name] = text
+end
+
+function Profiler.toggleOverlay()
+    state.visible = not state.visible
+end
+
+function Profiler.isVisible()
+    return state.visible
+end
+
+function Profiler.beginFrame()
+    if not state.enabled then return end
+    local now = getTime()
+    state.frame = state.frame + 1
+    state.slot = (state.frame - 1) % WINDOW + 1
+
+    local slot = state.slot
+    local samples, allocs = state.samples, state.allocs
+    for i = 1, #state.phases do
+        samples[state.phases[i]][slot] = 0
+        allocs[state.phases[i]][slot] = 0
+    end
+    if state.lastFrameStart then
+        state.frameTimes[slot] = now - state.lastFrameStart
+    end
+    state.lastFrameStart = now
+    state.frameStart = now
+end
+
+function Profiler.start(name)
+    if not state.enabled then return end
+    if not state.samples[name] then
+        addPhase(name)
+    end
+    state.heapStart[name] = collectgarbage("count")
+    state.started[name] = getTime()
+end
+
+function Profiler.stop(name)
+    local t0 = state.started[name]
+    if not t0 then return end
+    state.started[name] = nil
+    local samples = state.samples[name]
+    samples[state.slot] = samples[state.slot] + (getTime() - t0)
+    local grown = collectgarbage("count") - state.heapStart[name]
+    if grown > 0 then
+        local allocs = state.allocs[name]
+        allocs[state.slot] = allocs[state.slot] + grown
+    end
+end
+
+-- Call before drawing the overlay, so its own draw calls are not counted
+function Profiler.endFrame()
+    if not state.enabled or not state.frameStart then return end
+    state.cpuTimes[state.slot] = getTime() - state.frameStart
+    if love.graphics then
+        local stats = love.graphics.getStats(state.graphics)
+        state.drawCalls = stats.drawcalls
+        state.textureMemory = stats.texturememory
+    end
+end
+
+local function refreshStats()
+    local count = math.min(state.frame, WINDOW)
+    if count == 0 then return end
+    local scratch = state.scratch
+    for _, name in ipairs(state.phases) do
+        local samples, allocs = state.samples[name], state.allocs[name]
+        local sum, allocSum = 0, 0
+        for i = 1, count do
+            scratch[i] = samples[i]
+            sum = sum + samples[i]
+            allocSum = allocSum + allocs[i]
+        end
+        for i = count + 1, #scratch do
+            scratch[i] = nil
+        end
+        table.sort(scratch)
+        local s = state.stats[name]
+        s.min = scratch[1] * 1000
+        s.avg = sum / count * 1000
+        s.p99 = scratch[math.max(1, math.ceil(count * 0.99))] * 1000
+        s.alloc = allocSum / count
+    end
+    state.statsAge = 0
+end
+
+-- Mean of a phase over the last `count` finished frames, in
+-- milliseconds, or nil until that many have been recorded. Unlike
+-- getStats this is always current, overlay or not.
+function Profiler.recentAverage(name, count)
+    local samples = state.samples[name]
+    if not samples or count >= WINDOW or state.frame <= count then return nil end
+    local sum = 0
+    for frame = state.frame - count, state.frame - 1 do
+        sum = sum + samples[(frame - 1) % WINDOW + 1]
+    end
+    return sum / count * 1000
+end
+
+-- Rolling { min, avg, p99 } in milliseconds and average KB allocated
+-- per frame for a phase
+function Profiler.getStats(name)
+    return state.stats[name]
+end
+
+function Profiler.drawOverlay()
+    if not state.visible then return end
+    state.statsAge = state.statsAge + love.timer.getDelta()
+    if state.statsAge >= STATS_INTERVAL then
+        refreshStats()
+    end
+
+    local lg = love.graphics
+    local x, y = 8, 8
+    local lineH = 14
+    local width = 430
+    local graphH = 60
+    local lines = #state.phases + 4
+    for _, key in ipairs(state.statusKeys) do
+        if state.status[key] then lines = lines + 1 end
+    end
+    local height = lines * lineH + graphH + 16
+
+    lg.push("all")
+    lg.origin()
+    lg.setColor(0, 0, 0, 0.7)
+    lg.rectangle("fill", x, y, width, height)
+
+    -- The default font is proportional, so columns are placed explicitly
+    local col1, col2, col3, col4 = x + 150, x + 220, x + 290, x + 360
+    lg.setColor(1, 1, 1)
+    lg.print("phase (ms)", x + 6, y + 4)
+    lg.print("min", col1, y + 4)
+    lg.print("avg", col2, y + 4)
+    lg.print("p99", col3, y + 4)
+    lg.print("KB", col4, y + 4)
+    local ty = y + 4 + lineH
+    for _, name in ipairs(state.phases) do
+        local s = state.stats[name]
+        lg.print(name, x + 6, ty)
+        lg.print(string.format("%.2f", s.min), col1, ty)
+        lg.print(string.format("%.2f", s.avg), col2, ty)
+        lg.print(string.format("%.2f", s.p99), col3, ty)
+        lg.print(string.format("%.1f", s.alloc), col4, ty)
+        ty = ty + lineH
+    end
+    local heap = string.format("%.0f", collectgarbage("count"))
+    if state.heapBudget then
+        heap = heap .. string.format(" / %.0f", state.heapBudget)
+    end
+    lg.print(string.format("draw calls %d   lua %s KB   tex %.1f MB",
+        state.drawCalls, heap, state.textureMemory / 1048576), x + 6, ty)
+    ty = ty + lineH
+    for _, key in ipairs(state.statusKeys) do
+        local text = state.status[key]
+        if text then
+            lg.print(text, x + 6, ty)
+            ty = ty + lineH
+        end
+    end
+    ty = ty + 6
+
+    -- Frame-time graph, oldest on the left
+    local barW = (width - 12) / WINDOW
+    local count = math.min(state.frame, WINDOW)
+    for i = 1, count do
+        local slot = (state.frame - count + i - 1) % WINDOW + 1
+        local ms = state.frameTimes[slot] * 1000
+        local h = math.min(graphH, ms / GRAPH_MS * graphH)
+        if ms > 1000 / 60 + 0.5 then
+            lg.setColor(1, 0.35, 0.3)
+        else
+            lg.setColor(0.4, 1, 0.5)
+        end
+        lg.rectangle("fill", x + 6 + (i - 1) * barW, ty + graphH - h, math.max(1, barW), h)
+    end
+    lg.setColor(1, 1, 1, 0.4)
+    local budget = ty + graphH - (1000 / 60) / GRAPH_MS * graphH
+    lg.line(x + 6, budget, x + width - 6, budget)
+    lg.pop()
+end
+
+-- Writes the recorded window, one row per frame, oldest first
+function Profiler.dumpCSV(path)
+    local count = math.min(state.frame, WINDOW)
+    local lines = { "n," .. table.concat(state.phases, ",") }
+    local row = {}
+    for i = 1, count do
+        local frame = state.frame - count + i
+        local slot = (frame - 1) % WINDOW + 1
+        row[1] = tostring(frame)
+        for p, name in ipairs(state.phases) do
+            row[p + 1] = string.format("%.4f", state.samples[name][slot] * 1000)
+        end
+        lines[#lines + 1] = table.concat(row, ",", 1, #state.phases + 1)
+    end
+    return love.filesystem.write(path, table.concat(lines, "\n") .. "\n")
+end
+
+return Profiler
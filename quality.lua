@@ -0,0 +1,83 @@
+-- =========================================================
+-- ADAPTIVE QUALITY
+-- =========================================================
+-- Steps through a list of quality levels (best first) to hold a target
+-- frame time. Every INTERVAL seconds the recent frame and CPU times are
+-- compared with the target:
+--
+--   * frame time above target * DOWN_RATIO for DOWN_AFTER checks in a
+--     row drops one level
+--   * CPU time below target * UP_RATIO for UP_AFTER checks in a row
+--     raises one level (frame time alone cannot show headroom under
+--     vsync)
+--
+-- The gap between the two ratios, the unequal streaks and a pause after
+-- every change (so the new level is measured on its own frames) keep
+-- the level from oscillating.
+--
+--   local q = Quality.new(levels, 1000 / 60, apply)   -- apply(level, index)
+--   q:update(dt, frameMs, cpuMs)                       -- once per frame
+
+local Quality = {}
+Quality.__index = Quality
+
+Quality.INTERVAL = 0.5
+Quality.DOWN_RATIO = 1.15
+Quality.UP_RATIO = 0.6
+Quality.DOWN_AFTER = 2
+Quality.UP_AFTER = 6
+Quality.SETTLE = 2 -- seconds ignored after a change
+
+function Quality.new(levels, targetMs, apply)
+    local q = setmetatable({
+        levels = levels,
+        targetMs = targetMs,
+        apply = apply,
+        enabled = true,
+        index = 1,
+        timer = 0,
+        settle = 0,
+        over = 0, -- consecutive checks over budget
+        under = 0 -- consecutive checks with headroom
+    }, Quality)
+    apply(levels[1], 1)
+    return q
+end
+
+function Quality:set(index)
+    index = math.max(1, math.min(#self.levels, index))
+    self.over, self.under = 0, 0
+    self.settle = Quality.SETTLE
+    if index ~= self.index then
+        self.index = index
+        self.apply(self.levels[index], index)
+    end
+end
+
+-- frameMs / cpuMs are recent averages; nil skips the check
+function Quality:update(dt, frameMs, cpuMs)
+    if not self.enabled then return end
+    if self.settle > 0 then
+        self.settle = self.settle - dt
+        return
+    end
+    self.timer = self.timer + dt
+    if self.timer < Quality.INTERVAL or not frameMs or not cpuMs then return end
+    self.timer = 0
+
+    if frameMs > self.targetMs * Quality.DOWN_RATIO then
+        self.over, self.under = self.over + 1, 0
+    elseif cpuMs < self.targetMs * Quality.UP_RATIO then
+        self.over, self.under = 0, self.under + 1
+    else
+        self.over, self.under = 0, 0
+    end
+
+    if self.over >= Quality.DOWN_AFTER and self.index < #self.levels then
+        self:set(self.index + 1)
+    elseif self.under >= Quality.UP_AFTER and self.index > 1 then
+        self:set(self.index - 1)
+    end
+end
+
+return Quality
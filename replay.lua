@@ -0,0 +1,140 @@
+-- =========================================================
+-- INPUT RECORDING AND PLAYBACK
+-- =========================================================
+-- A recording is the random seed plus every input action change,
+-- stamped with the simulation tick it took effect on. Starting from the
+-- same state and seed, feeding the events back at the same ticks
+-- reproduces a session exactly.
+--
+-- File layout (little endian):
+--
+--   "GGIN"  magic
+--   u16     version
+--   u32     seed
+--   u32     length (ticks)
+--   u32     event count
+--   events  varint tick delta, then u8 (action id * 2 + down)
+
+require("love.data")
+
+local Replay = {}
+
+Replay.MAGIC = "GGIN"
+Replay.VERSION = 1
+
+local HEADER_FORMAT = "<I2I4I4I4"
+local HEADER_SIZE = 4 + 14
+
+-- Action ids are part of the file format; append only
+Replay.ACTIONS = { "left", "right", "jump", "dash", "fire" }
+local ACTION_IDS = {}
+for id, name in ipairs(Replay.ACTIONS) do
+    ACTION_IDS[name] = id
+end
+
+function Replay.new(seed)
+    return {
+        seed = seed,
+        length = 0,
+        count = 0,
+        ticks = {},
+        actions = {},
+        downs = {}
+    }
+end
+
+function Replay.record(rec, tick, action, down)
+    local n = rec.count + 1
+    rec.count = n
+    rec.ticks[n] = tick
+    rec.actions[n] = action
+    rec.downs[n] = down
+    rec.length = math.max(rec.length, tick)
+end
+
+function Replay.encode(rec)
+    local char, floor = string.char, math.floor
+    local parts = {
+        Replay.MAGIC,
+        love.data.pack("string", HEADER_FORMAT, Replay.VERSION, rec.seed, rec.length, rec.count)
+    }
+    local last = 0
+    for i = 1, rec.count do
+        local delta = rec.ticks[i] - last
+        last = rec.ticks[i]
+        while delta >= 128 do
+            parts[#parts + 1] = char(delta % 128 + 128)
+            delta = floor(delta / 128)
+        end
+        parts[#parts + 1] = char(delta, ACTION_IDS[rec.actions[i]] * 2 + (rec.downs[i] and 1 or 0))
+    end
+    return table.concat(parts)
+end
+
+function Replay.decode(data)
+    if #data < HEADER_SIZE or data:sub(1, 4) ~= Replay.MAGIC then
+        return nil, "not a replay file"
+    end
+    local version, seed, length, count = love.data.unpack(HEADER_FORMAT, data, 5)
+    if version ~= Replay.VERSION then
+        return nil, "unsupported replay version " .. version
+    end
+
+    local byte = string.byte
+    local rec = Replay.new(seed)
+    local pos = HEADER_SIZE + 1
+    local tick = 0
+    for _ = 1, count do
+        local delta, scale = 0, 1
+        local b = byte(data, pos)
+        while b >= 128 do
+            delta = delta + (b - 128) * scale
+            scale = scale * 128
+            pos = pos + 1
+            b = byte(data, pos)
+        end
+        delta = delta + b * scale
+        local code = byte(data, pos + 1)
+        pos = pos + 2
+        tick = tick + delta
+        Replay.record(rec, tick, Replay.ACTIONS[math.floor(code / 2)], code % 2 == 1)
+    end
+    rec.length = length
+    return rec
+end
+
+function Replay.save(path, rec)
+    local dir = path:match("^(.*)/[^/]*$")
+    if dir then
+        love.filesystem.createDirectory(dir)
+    end
+    return love.filesystem.write(path, Replay.encode(rec))
+end
+
+function Replay.load(path)
+    local data, err = love.filesystem.read(path)
+    if not data then
+        return nil, err
+    end
+    return Replay.decode(data)
+end
+
+-- Playback cursor over a recording
+function Replay.newPlayback(rec)
+    return { rec = rec, cursor = 1 }
+end
+
+-- Calls onAction(action, down) for every event stamped `tick`.
+-- Returns false once the recording has ended.
+function Replay.playStep(playback, tick, onAction)
+    local rec = playback.rec
+    local i = playback.cursor
+    while i <= rec.count and rec.ticks[i] <= tick do
+        onAction(rec.actions[i], rec.downs[i])
+        i = i + 1
+    end
+    playback.cursor = i
+    return tick < rec.length
+end
+
+return Replay
@@ -0,0 +1,87 @@
+-- =========================================================
+-- ROOM GRAPH
+-- =========================================================
+-- Rooms are tile rectangles joined by portals, which are where the
+-- player moves from one room to the next. Each room knows its portals,
+-- the rooms they lead to and the chunks it covers, so loading can follow
+-- the map's structure: the room the player is in plus everything one
+-- portal away, whatever the total size of the map.
+--
+--   local graph = Rooms.new(WorldGen.ROOMS, WorldGen.PORTALS, CHUNK, chunkCols)
+--   local room = graph:track(tx, ty)   -- room the player is in
+--   for _, index in ipairs(room.chunks) do ... end
+--   for _, n in ipairs(room.neighbours) do ... end
+
+local Rooms = {}
+Rooms.__index = Rooms
+
+local function contains(r, tx, ty)
+    return tx >= r.x1 and tx <= r.x2 and ty >= r.y1 and ty <= r.y2
+end
+
+-- rooms: { name, x1, y1, x2, y2 }; portals: { roomA, roomB, x1, y1, x2, y2 }
+function Rooms.new(rooms, portals, chunkSize, chunkCols)
+    local list = {}
+    for id, r in ipairs(rooms) do
+        local room = {
+            id = id, name = r[1],
+            x1 = r[2], y1 = r[3], x2 = r[4], y2 = r[5],
+            neighbours = {},
+            portals = {},
+            chunks = {} -- chunk indices overlapping the room
+        }
+        for cy = math.floor((room.y1 - 1) / chunkSize) + 1, math.floor((room.y2 - 1) / chunkSize) + 1 do
+            for cx = math.floor((room.x1 - 1) / chunkSize) + 1, math.floor((room.x2 - 1) / chunkSize) + 1 do
+                room.chunks[#room.chunks + 1] = (cy - 1) * chunkCols + cx
+            end
+        end
+        list[id] = room
+    end
+
+    for _, p in ipairs(portals) do
+        local a, b = list[p[1]], list[p[2]]
+        local portal = { a = a, b = b, x1 = p[3], y1 = p[4], x2 = p[5], y2 = p[6] }
+        a.neighbours[#a.neighbours + 1] = b
+        b.neighbours[#b.neighbours + 1] = a
+        a.portals[#a.portals + 1] = portal
+        b.portals[#b.portals + 1] = portal
+    end
+
+    return setmetatable({ rooms = list, current = nil }, Rooms)
+end
+
+-- Room containing tile (tx, ty), or nil
+function Rooms:find(tx, ty)
+    for _, room in ipairs(self.rooms) do
+        if contains(room, tx, ty) then return room end
+    end
+    return nil
+end
+
+-- Updates and returns the current room for a player at tile (tx, ty).
+-- The room changes through portals: standing on one of the current
+-- room's portals, past the edge of the room into the other one, moves
+-- the player across; on a portal but still inside, nothing changes.
+-- Only a position outside the room and all its portals (a teleport or
+-- reset) searches the whole graph.
+function Rooms:track(tx, ty)
+    local room = self.current
+    if room then
+        for _, portal in ipairs(room.portals) do
+            if contains(portal, tx, ty) then
+                local other = portal.a == room and portal.b or portal.a
+                if not contains(room, tx, ty) and contains(other, tx, ty) then
+                    self.current = other
+                end
+                return self.current
+            end
+        end
+        if contains(room, tx, ty) then
+            return room
+        end
+    end
+    self.current = self:find(tx, ty) or room
+    return self.current
+end
+
+return Rooms
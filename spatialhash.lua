@@ -0,0 +1,146 @@
+-- =========================================================
+-- SPATIAL HASH (UNIFORM GRID BROADPHASE)
+-- =========================================================
+-- Items are integer ids with an axis-aligned box. Each item is listed
+-- in every cell its box touches; moving an item only touches the cell
+-- lists when its cell range actually changes. Queries write into a
+-- caller-owned array so they do not allocate.
+
+local SpatialHash = {}
+SpatialHash.__index = SpatialHash
+
+-- Cell coordinates are folded into a single numeric key
+local KEY_STRIDE = 1048576
+
+function SpatialHash.new(cellSize)
+    return setmetatable({
+        cellSize = cellSize,
+        cells = {},
+        -- per-item box and cell range
+        x = {}, y = {}, w = {}, h = {},
+        cx1 = {}, cy1 = {}, cx2 = {}, cy2 = {},
+        -- query dedupe
+        stamp = 0,
+        seen = {}
+    }, SpatialHash)
+end
+
+function SpatialHash:cellRange(x, y, w, h)
+    local size = self.cellSize
+    return math.floor(x / size), math.floor(y / size),
+        math.floor((x + w) / size), math.floor((y + h) / size)
+end
+
+function SpatialHash:addToCells(id, cx1, cy1, cx2, cy2)
+    local cells = self.cells
+    for cy = cy1, cy2 do
+        for cx = cx1, cx2 do
+            local key = cy * KEY_STRIDE + cx
+            local cell = cells[key]
+            if not cell then
+                cell = {}
+                cells[key] = cell
+            end
+            cell[id] = true
+        end
+    end
+end
+
+function SpatialHash:removeFromCells(id, cx1, cy1, cx2, cy2)
+    local cells = self.cells
+    for cy = cy1, cy2 do
+        for cx = cx1, cx2 do
+            local cell = cells[cy * KEY_STRIDE + cx]
+            if cell then cell[id] = nil end
+        end
+    end
+end
+
+function SpatialHash:insert(id, x, y, w, h)
+    local cx1, cy1, cx2, cy2 = self:cellRange(x, y, w, h)
+    self.x[id], self.y[id], self.w[id], self.h[id] = x, y, w, h
+    self.cx1[id], self.cy1[id], self.cx2[id], self.cy2[id] = cx1, cy1, cx2, cy2
+    self:addToCells(id, cx1, cy1, cx2, cy2)
+end
+
+function SpatialHash:update(id, x, y, w, h)
+    if not self.cx1[id] then
+        return self:insert(id, x, y, w, h)
+    end
+    self.x[id], self.y[id], self.w[id], self.h[id] = x, y, w, h
+
+    local cx1, cy1, cx2, cy2 = self:cellRange(x, y, w, h)
+    local ox1, oy1, ox2, oy2 = self.cx1[id], self.cy1[id], self.cx2[id], self.cy2[id]
+    if cx1 == ox1 and cy1 == oy1 and cx2 == ox2 and cy2 == oy2 then
+        return
+    end
+    self:removeFromCells(id, ox1, oy1, ox2, oy2)
+    self:addToCells(id, cx1, cy1, cx2, cy2)
+    self.cx1[id], self.cy1[id], self.cx2[id], self.cy2[id] = cx1, cy1, cx2, cy2
+end
+
+function SpatialHash:remove(id)
+    if not self.cx1[id] then return end
+    self:removeFromCells(id, self.cx1[id], self.cy1[id], self.cx2[id], self.cy2[id])
+    self.x[id], self.y[id], self.w[id], self.h[id] = nil, nil, nil, nil
+    self.cx1[id], self.cy1[id], self.cx2[id], self.cy2[id] = nil, nil, nil, nil
+end
+
+-- Re-keys an item, for stores that compact ids by swap-remove
+function SpatialHash:rename(from, to)
+    if from == to or not self.cx1[from] then return end
+    local x, y, w, h = self.x[from], self.y[from], self.w[from], self.h[from]
+    self:remove(from)
+    self:remove(to)
+    self:insert(to, x, y, w, h)
+end
+
+-- Fills `out` with the ids of items overlapping the rect and returns
+-- the count. Entries past the count are left untouched.
+function SpatialHash:queryRect(x, y, w, h, out)
+    local cells, seen = self.cells, self.seen
+    local ix, iy, iw, ih = self.x, self.y, self.w, self.h
+    local stamp = self.stamp + 1
+    self.stamp = stamp
+
+    local n = 0
+    local cx1, cy1, cx2, cy2 = self:cellRange(x, y, w, h)
+    for cy = cy1, cy2 do
+        for cx = cx1, cx2 do
+            local cell = cells[cy * KEY_STRIDE + cx]
+            if cell then
+                for id in pairs(cell) do
+                    if seen[id] ~= stamp then
+                        seen[id] = stamp
+                        if ix[id] < x + w and ix[id] + iw[id] > x
+                            and iy[id] < y + h and iy[id] + ih[id] > y then
+                            n = n + 1
+                            out[n] = id
+                        end
+                    end
+                end
+            end
+        end
+    end
+    return n
+end
+
+-- Items whose box comes within `r` of the point (px, py)
+function SpatialHash:queryRadius(px, py, r, out)
+    local n = self:queryRect(px - r, py - r, r * 2, r * 2, out)
+    local ix, iy, iw, ih = self.x, self.y, self.w, self.h
+    local r2 = r * r
+    local kept = 0
+    for i = 1, n do
+        local id = out[i]
+        local dx = px - math.max(ix[id], math.min(px, ix[id] + iw[id]))
+        local dy = py - math.max(iy[id], math.min(py, iy[id] + ih[id]))
+        if dx * dx + dy * dy <= r2 then
+            kept = kept + 1
+            out[kept] = id
+        end
+    end
+    return kept
+end
+
+return SpatialHash
@@ -0,0 +1,25 @@
+-- =========================================================
+-- WORLD STREAMING WORKER (love.thread)
+-- =========================================================
+-- Reads chunks for the main thread. Requests are chunk indices pushed
+-- on the request channel; each reply is { index, data } where data is
+-- the chunk's raw tile bytes. Pushing "quit" stops the worker.
+
+require("love.filesystem")
+local Level = require("level")
+
+local path, requests, results = ...
+
+local header = assert(Level.readHeader(path))
+local file = love.filesystem.newFile(path, "r")
+
+while true do
+    local msg = requests:demand()
+    if msg == "quit" then break end
+
+    local cx = (msg - 1) % header.chunkCols + 1
+    local cy = math.floor((msg - 1) / header.chunkCols) + 1
+    results:push({ index = msg, data = Level.readChunk(file, header, cx, cy) })
+end
+
+file:close()
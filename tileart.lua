@@ -0,0 +1,46 @@
+-- =========================================================
+-- TILE ART
+-- =========================================================
+-- Paints the stand-in tile images: a base colour, bevels on the sides
+-- that do not connect to a neighbour, and an optional crack pattern.
+-- Only love.image is used, so this also runs on asset workers.
+--
+-- Masks use the bit order of world.masks (see AUTOTILE MASKS in
+-- main.lua).
+
+require("love.image")
+local bit = require("bit")
+
+local TileArt = {}
+
+local N, E, S, W = 1, 2, 4, 8
+local NE, SE, SW, NW = 16, 32, 64, 128
+
+-- spec: { size, r, g, b, cracked, mask }, flat so it can be sent over
+-- a love.thread channel
+function TileArt.paint(spec)
+    local size, r, g, b, mask = spec.size, spec.r, spec.g, spec.b, spec.mask
+    local data = love.image.newImageData(size, size)
+    local near, far = 2, size - 3
+    local function open(bitmask) return bit.band(mask, bitmask) == 0 end
+    data:mapPixel(function(x, y)
+        local shade = 1
+        local top, left = y < near, x < near
+        local bottom, right = y > far, x > far
+        if (top and open(N)) or (left and open(W)) then
+            shade = 1.2
+        elseif (bottom and open(S)) or (right and open(E)) then
+            shade = 0.7
+        elseif (top and left and open(NW)) or (top and right and open(NE)) then
+            shade = 1.2
+        elseif (bottom and left and open(SW)) or (bottom and right and open(SE)) then
+            shade = 0.7
+        elseif spec.cracked and ((x + y) % 11 == 0 or (x - y) % 13 == 0) then
+            shade = 0.6
+        end
+        return math.min(1, r * shade), math.min(1, g * shade), math.min(1, b * shade), 1
+    end)
+    return data
+end
+
+return TileArt
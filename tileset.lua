@@ -0,0 +1,91 @@
+-- =========================================================
+-- TILESET ATLAS
+-- =========================================================
+-- Packs tile images into one texture and hands out a quad per key, so
+-- a SpriteBatch can draw any mix of tiles in a single call. Each tile
+-- is surrounded by `padding` pixels copied from its own edges
+-- (extrusion): when filtering or subpixel offsets sample past a tile's
+-- border they pick up the same colour instead of the neighbouring tile.
+--
+--   local set = Tileset.new(32, 2)
+--   set:add(TILE_SOLID, imageData)   -- tileSize x tileSize ImageData
+--   set:build()
+--   batch:add(set:getQuad(TILE_SOLID), x, y)
+
+local Tileset = {}
+Tileset.__index = Tileset
+
+function Tileset.new(tileSize, padding)
+    return setmetatable({
+        tileSize = tileSize,
+        padding = padding or 1,
+        keys = {}, -- insertion order
+        sources = {}, -- [key] = ImageData, until build
+        quads = {}, -- [key] = Quad, after build
+        image = nil
+    }, Tileset)
+end
+
+function Tileset:add(key, imageData)
+    assert(imageData:getWidth() == self.tileSize and imageData:getHeight() == self.tileSize,
+        "tile images must be tileSize square")
+    if not self.sources[key] then
+        self.keys[#self.keys + 1] = key
+    end
+    self.sources[key] = imageData
+end
+
+-- Copies the source's edges outwards into the padding around (dx, dy)
+local function extrude(atlas, source, dx, dy, size, pad)
+    local last = size - 1
+    for k = 1, pad do
+        atlas:paste(source, dx, dy - k, 0, 0, size, 1)
+        atlas:paste(source, dx, dy + last + k, 0, last, size, 1)
+        atlas:paste(source, dx - k, dy, 0, 0, 1, size)
+        atlas:paste(source, dx + last + k, dy, last, 0, 1, size)
+    end
+    local corners = { { 0, 0, -1, -1 }, { last, 0, 1, -1 }, { 0, last, -1, 1 }, { last, last, 1, 1 } }
+    for _, c in ipairs(corners) do
+        local r, g, b, a = source:getPixel(c[1], c[2])
+        for ky = 1, pad do
+            for kx = 1, pad do
+                atlas:setPixel(dx + c[1] + c[3] * kx, dy + c[2] + c[4] * ky, r, g, b, a)
+            end
+        end
+    end
+end
+
+-- Packs every added tile into the atlas texture and creates the quads
+function Tileset:build()
+    local size, pad = self.tileSize, self.padding
+    local cell = size + pad * 2
+    local count = #self.keys
+    local cols = math.max(1, math.ceil(math.sqrt(count)))
+    local rows = math.max(1, math.ceil(count / cols))
+    local width, height = cols * cell, rows * cell
+
+    local atlas = love.image.newImageData(width, height)
+    for slot, key in ipairs(self.keys) do
+        local source = self.sources[key]
+        local dx = ((slot - 1) % cols) * cell + pad
+        local dy = math.floor((slot - 1) / cols) * cell + pad
+        atlas:paste(source, dx, dy, 0, 0, size, size)
+        extrude(atlas, source, dx, dy, size, pad)
+        self.quads[key] = love.graphics.newQuad(dx, dy, size, size, width, height)
+        self.sources[key] = nil
+    end
+
+    if self.image then
+        self.image:release()
+    end
+    self.image = love.graphics.newImage(atlas)
+    self.image:setFilter("nearest", "nearest")
+    atlas:release()
+    return self.image
+end
+
+function Tileset:getQuad(key)
+    return self.quads[key]
+end
+
+return Tileset
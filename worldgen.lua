@@ -0,0 +1,81 @@
+-- =========================================================
+-- WORLD GENERATOR
+-- =========================================================
+-- Builds the built-in level layout one chunk at a time, so chunks can
+-- be generated independently (and in parallel, see genworker.lua).
+-- Only plain Lua is used, so this module also loads inside
+-- love.thread workers.
+
+local WorldGen = {}
+
+-- Bump when the layout changes, so stale baked files are not reused
+WorldGen.REVISION = 2
+
+WorldGen.WIDTH = 120
+WorldGen.HEIGHT = 40
+
+-- Filled rectangles { x1, y1, x2, y2, id } in tiles, applied in order
+-- over an empty world
+local FILLS = {
+    -- Ground
+    { 1, 35, WorldGen.WIDTH, WorldGen.HEIGHT, 1 },
+
+    -- Boundaries
+    { 1, 1, 1, WorldGen.HEIGHT, 1 },
+    { WorldGen.WIDTH, 1, WorldGen.WIDTH, WorldGen.HEIGHT, 1 },
+
+    -- Platforms
+    { 10, 30, 20, 30, 1 },
+    { 25, 26, 35, 26, 1 },
+    { 40, 28, 55, 28, 1 },
+    { 60, 24, 75, 24, 1 },
+    { 80, 29, 100, 29, 1 },
+
+    -- Shafts
+    { 22, 20, 22, 34, 1 },
+    { 58, 18, 58, 34, 1 },
+    { 78, 15, 78, 34, 1 },
+
+    -- Breakable wall under the x=60..75 platform
+    { 66, 29, 67, 34, 2 }
+}
+
+-- Rooms { name, x1, y1, x2, y2 } in tiles. They cover the world
+-- without overlapping, split at the shafts.
+WorldGen.ROOMS = {
+    { "west", 1, 1, 22, WorldGen.HEIGHT },
+    { "middle", 23, 1, 58, WorldGen.HEIGHT },
+    { "tower", 59, 1, 78, WorldGen.HEIGHT },
+    { "east", 79, 1, WorldGen.WIDTH, WorldGen.HEIGHT }
+}
+
+-- Portals { roomA, roomB, x1, y1, x2, y2 }: the tiles where the player
+-- can cross from one room into the other (above each shaft)
+WorldGen.PORTALS = {
+    { 1, 2, 22, 1, 23, 19 },
+    { 2, 3, 58, 1, 59, 17 },
+    { 3, 4, 78, 1, 79, 14 }
+}
+
+-- Writes chunk (cx, cy) of a `size` x `size` chunk grid into `out` as
+-- size * size row-major tile ids. Tiles past the world edge are 0.
+function WorldGen.generateChunk(cx, cy, size, out)
+    for i = 1, size * size do
+        out[i] = 0
+    end
+
+    local x0, y0 = (cx - 1) * size, (cy - 1) * size
+    for _, f in ipairs(FILLS) do
+        local x1, y1 = math.max(f[1], x0 + 1), math.max(f[2], y0 + 1)
+        local x2, y2 = math.min(f[3], x0 + size), math.min(f[4], y0 + size)
+        for ty = y1, y2 do
+            local row = (ty - y0 - 1) * size - x0
+            for tx = x1, x2 do
+                out[row + tx] = f[5]
+            end
+        end
+    end
+    return out
+end
+
+return WorldGen